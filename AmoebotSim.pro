@@ -8,79 +8,36 @@ QMAKE_INFO_PLIST = res/Info.plist
 
 win32:RC_FILE = res/AmoebotSim.rc
 
+include(AmoebotSimCore.pri)
+
 HEADERS += \
-    alg/demo/ballroomdemo.h \
-    alg/demo/discodemo.h \
-    alg/demo/dynamicdemo.h \
-    alg/demo/metricsdemo.h \
-    alg/demo/spf.h \
-    alg/demo/tokendemo.h \
-    alg/aggregation.h \
-    alg/compression.h \
-    alg/edfhexagonformation.h \
-    alg/edfleaderelectionbyerosion.h \
-    alg/energyshape.h \
-    alg/energysharing.h \
-    alg/hexagonformation.h \
-    alg/infobjcoating.h \
-    alg/leaderelectionbyerosion.h \
-    alg/shapeformation.h \
-    core/amoebotparticle.h \
-    core/amoebotsystem.h \
-    core/localparticle.h \
-    core/metric.h \
-    core/node.h \
-    core/object.h \
-    core/particle.h \
+    core/rendersnapshot.h \
     core/simulator.h \
-    core/system.h \
-    helper/randomnumbergenerator.h \
     main/application.h \
     script/scriptengine.h \
     script/scriptinterface.h \
-    ui/algorithm.h \
+    ui/densitymap.h \
     ui/glitem.h \
     ui/parameterlistmodel.h \
+    ui/particlerenderer.h \
+    ui/tileindex.h \
     ui/view.h \
-    ui/visitem.h \
-    alg/leaderelection.h
+    ui/visitem.h
 
 SOURCES += \
-    alg/demo/ballroomdemo.cpp \
-    alg/demo/discodemo.cpp \
-    alg/demo/dynamicdemo.cpp \
-    alg/demo/metricsdemo.cpp \
-    alg/demo/spf.cpp \
-    alg/demo/tokendemo.cpp \
-    alg/aggregation.cpp \
-    alg/compression.cpp \
-    alg/edfhexagonformation.cpp \
-    alg/edfleaderelectionbyerosion.cpp \
-    alg/energyshape.cpp \
-    alg/energysharing.cpp \
-    alg/hexagonformation.cpp \
-    alg/infobjcoating.cpp \
-    alg/leaderelectionbyerosion.cpp \
-    alg/shapeformation.cpp \
-    core/amoebotparticle.cpp \
-    core/amoebotsystem.cpp \
-    core/localparticle.cpp \
-    core/metric.cpp \
-    core/object.cpp \
-    core/particle.cpp \
+    core/rendersnapshot.cpp \
     core/simulator.cpp \
-    core/system.cpp \
-    helper/randomnumbergenerator.cpp \
     main/application.cpp \
     main/main.cpp\
     script/scriptengine.cpp \
     script/scriptinterface.cpp \
-    ui/algorithm.cpp \
+    ui/densitymap.cpp \
     ui/glitem.cpp \
     ui/parameterlistmodel.cpp \
+    ui/particlerenderer.cpp \
+    ui/tileindex.cpp \
     ui/view.cpp \
-    ui/visitem.cpp \
-    alg/leaderelection.cpp
+    ui/visitem.cpp
 
 RESOURCES += \
     res/qml.qrc \
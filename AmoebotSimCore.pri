@@ -0,0 +1,75 @@
+# Sources shared by the GUI application (AmoebotSim.pro) and the headless batch
+# runner (batch/AmoebotSimBatch.pro): the amoebot model, the algorithms, and the
+# algorithm registry. Everything listed here must only depend on QtCore.
+
+INCLUDEPATH += $$PWD
+
+HEADERS += \
+    $$PWD/alg/demo/ballroomdemo.h \
+    $$PWD/alg/demo/discodemo.h \
+    $$PWD/alg/demo/dynamicdemo.h \
+    $$PWD/alg/demo/metricsdemo.h \
+    $$PWD/alg/demo/spf.h \
+    $$PWD/alg/demo/tokendemo.h \
+    $$PWD/alg/aggregation.h \
+    $$PWD/alg/compression.h \
+    $$PWD/alg/edfhexagonformation.h \
+    $$PWD/alg/edfleaderelectionbyerosion.h \
+    $$PWD/alg/energyshape.h \
+    $$PWD/alg/energysharing.h \
+    $$PWD/alg/hexagonformation.h \
+    $$PWD/alg/infobjcoating.h \
+    $$PWD/alg/leaderelectionbyerosion.h \
+    $$PWD/alg/shapeformation.h \
+    $$PWD/core/amoebotparticle.h \
+    $$PWD/core/amoebotsystem.h \
+    $$PWD/core/amoebotsystemt.h \
+    $$PWD/core/localparticle.h \
+    $$PWD/core/metric.h \
+    $$PWD/core/node.h \
+    $$PWD/core/object.h \
+    $$PWD/core/occupancyindex.h \
+    $$PWD/core/particle.h \
+    $$PWD/core/particlepool.h \
+    $$PWD/core/scheduler.h \
+    $$PWD/core/statetally.h \
+    $$PWD/core/system.h \
+    $$PWD/core/tokenpool.h \
+    $$PWD/core/workerpool.h \
+    $$PWD/helper/randomnumbergenerator.h \
+    $$PWD/ui/algorithm.h \
+    $$PWD/alg/leaderelection.h
+
+SOURCES += \
+    $$PWD/alg/demo/ballroomdemo.cpp \
+    $$PWD/alg/demo/discodemo.cpp \
+    $$PWD/alg/demo/dynamicdemo.cpp \
+    $$PWD/alg/demo/metricsdemo.cpp \
+    $$PWD/alg/demo/spf.cpp \
+    $$PWD/alg/demo/tokendemo.cpp \
+    $$PWD/alg/aggregation.cpp \
+    $$PWD/alg/compression.cpp \
+    $$PWD/alg/edfhexagonformation.cpp \
+    $$PWD/alg/edfleaderelectionbyerosion.cpp \
+    $$PWD/alg/energyshape.cpp \
+    $$PWD/alg/energysharing.cpp \
+    $$PWD/alg/hexagonformation.cpp \
+    $$PWD/alg/infobjcoating.cpp \
+    $$PWD/alg/leaderelectionbyerosion.cpp \
+    $$PWD/alg/shapeformation.cpp \
+    $$PWD/core/amoebotparticle.cpp \
+    $$PWD/core/amoebotsystem.cpp \
+    $$PWD/core/localparticle.cpp \
+    $$PWD/core/metric.cpp \
+    $$PWD/core/object.cpp \
+    $$PWD/core/occupancyindex.cpp \
+    $$PWD/core/particle.cpp \
+    $$PWD/core/particlepool.cpp \
+    $$PWD/core/scheduler.cpp \
+    $$PWD/core/statetally.cpp \
+    $$PWD/core/system.cpp \
+    $$PWD/core/tokenpool.cpp \
+    $$PWD/core/workerpool.cpp \
+    $$PWD/helper/randomnumbergenerator.cpp \
+    $$PWD/ui/algorithm.cpp \
+    $$PWD/alg/leaderelection.cpp
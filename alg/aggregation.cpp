@@ -141,10 +141,10 @@ bool AggregateParticle::checkIfParticleInSight() const {
 
 AggregateSystem::AggregateSystem(int numParticles, QString mode,
                                  double noiseVal) {
-  _measures.push_back(new SEDMeasure("SED circumference", 1, *this));
-  _measures.push_back(new ConvexHullMeasure("Convex Hull Perim", 1, *this));
-  _measures.push_back(new DispersionMeasure("Dispersion", 1, *this));
-  _measures.push_back(new ClusterFractionMeasure("Cluster Fraction", 1, *this));
+  registerMeasure(new SEDMeasure("SED circumference", 1, *this));
+  registerMeasure(new ConvexHullMeasure("Convex Hull Perim", 1, *this));
+  registerMeasure(new DispersionMeasure("Dispersion", 1, *this));
+  registerMeasure(new ClusterFractionMeasure("Cluster Fraction", 1, *this));
 
   Q_ASSERT(mode == "d" or mode == "e");
   Q_ASSERT(noiseVal >= 0);
@@ -4,10 +4,6 @@
 
 #include "alg/compression.h"
 
-#include <algorithm>  // For distance() and find().
-#include <set>
-#include <vector>
-
 #include <QtGlobal>
 
 CompressionParticle::CompressionParticle(const Node head,
@@ -28,7 +24,7 @@ void CompressionParticle::activate() {
 
     if (canExpand(expandDir) && !hasExpNbr()) {
       // Count neighbors in original position and expand.
-      numNbrsBefore = nbrCount(uniqueLabels());
+      numNbrsBefore = nbrCount(uniqueLabelMask());
       expand(expandDir);
       flag = !hasExpNbr();
     }
@@ -37,18 +33,15 @@ void CompressionParticle::activate() {
       contractHead();
     } else {
       // Count neighbors in new position and compute the set S.
-      int numNbrsAfter = nbrCount(headLabels());
-      std::vector<int> S;
-      for (const int label : {headLabels()[4], tailLabels()[4]}) {
-        if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-          S.push_back(label);
-        }
-      }
+      const unsigned int nbrs = countedNbrMask();
+      int numNbrsAfter = maskSize(headLabelMask() & nbrs);
+      const unsigned int S = labelsToMask({headLabels()[4], tailLabels()[4]})
+                             & nbrs;
 
       // If the conditions are satisfied, contract to the new position;
       // otherwise, contract back to the original one.
       if ((q < pow(lambda, numNbrsAfter - numNbrsBefore))
-          && (checkProp1(S) || checkProp2(S))) {
+          && (checkProp1(S, nbrs) || checkProp2(S, nbrs))) {
         contractTail();
       } else {
         contractHead();
@@ -75,7 +68,7 @@ QString CompressionParticle::inspectionText() const {
   } else {  // isExpanded().
     text += "Expanded properties:\n";
     text += "  #neighbors before = " + QString::number(numNbrsBefore) + ",\n";
-    text += "  #neighbors after = " + QString::number(nbrCount(headLabels()))
+    text += "  #neighbors after = " + QString::number(nbrCount(headLabelMask()))
             + ".\n";
   }
 
@@ -101,101 +94,57 @@ bool CompressionParticle::hasExpHeadAtLabel(const int label) const {
          && nbrAtLabel(label).pointsAtMyHead(*this, label);
 }
 
-int CompressionParticle::nbrCount(std::vector<int> labels) const {
-  int numNbrs = 0;
-  for (const int label : labels) {
-    if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-      ++numNbrs;
-    }
-  }
+unsigned int CompressionParticle::countedNbrMask() const {
+  return labelMask([this](int label) {
+    return hasNbrAtLabel(label) && !hasExpHeadAtLabel(label);
+  });
+}
 
-  return numNbrs;
+int CompressionParticle::nbrCount(unsigned int labels) const {
+  return maskSize(labels & countedNbrMask());
 }
 
-bool CompressionParticle::checkProp1(std::vector<int> S) const {
+bool CompressionParticle::checkProp1(unsigned int S, unsigned int nbrs) const {
   Q_ASSERT(isExpanded());
-  Q_ASSERT(S.size() <= 2);
+  Q_ASSERT(maskSize(S) <= 2);
   Q_ASSERT(flag);  // Not required, but equivalent/cleaner for implementation.
 
-  if (S.size() == 0) {
+  if (S == 0) {
     return false;  // S has to be nonempty for Property 1.
   } else {
-    const std::vector<int> labels = uniqueLabels();
-    std::set<int> adjNbrs;
-
-    // Starting from the particles in S, sweep out and mark connected neighbors.
-    for (int s : S) {
-      adjNbrs.insert(s);
-      int i = distance(labels.begin(), find(labels.begin(), labels.end(), s));
-
-      // First sweep counter-clockwise, stopping when an unoccupied position or
-      // expanded head is encountered.
-      for (uint offset = 1; offset < labels.size(); ++offset) {
-        int label = labels[(i + offset) % labels.size()];
-        if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-          adjNbrs.insert(label);
-        } else {
-          break;
-        }
-      }
-
-      // Then sweep clockwise.
-      for (uint offset = 1; offset < labels.size(); ++offset) {
-        int label = labels[(i - offset + labels.size()) % labels.size()];
-        if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-          adjNbrs.insert(label);
-        } else {
-          break;
-        }
-      }
-    }
+    // Starting from the particles in S, sweep out and mark connected neighbors
+    // around the ring of labels. The two non-unique labels address the same
+    // positions as their clockwise neighbors, so they never split or join any
+    // runs of neighbors.
+    const unsigned int adjNbrs = maskComponent(nbrs, S, 10);
 
     // If all neighbors are connected to a particle in S by a path through the
-    // neighborhood, then the number of labels in adjNbrs should equal the total
-    // number of neighbors.
-    return adjNbrs.size() == (uint)nbrCount(labels);
+    // neighborhood, then the number of unique labels in adjNbrs should equal
+    // the total number of neighbors.
+    const unsigned int labels = uniqueLabelMask();
+    return maskSize(adjNbrs & labels) == maskSize(nbrs & labels);
   }
 }
 
-bool CompressionParticle::checkProp2(std::vector<int> S) const {
+bool CompressionParticle::checkProp2(unsigned int S, unsigned int nbrs) const {
   Q_ASSERT(isExpanded());
-  Q_ASSERT(S.size() <= 2);
+  Q_ASSERT(maskSize(S) <= 2);
   Q_ASSERT(flag);  // Not required, but equivalent/cleaner for implementation.
 
-  if (S.size() != 0) {
+  if (S != 0) {
     return false;  // S has to be empty for Property 2.
   } else {
-    const int numHeadNbrs = nbrCount(headLabels());
-    const int numTailNbrs = nbrCount(tailLabels());
-
-    // Check if the head's neighbors are connected.
-    int numAdjHeadNbrs = 0;
-    bool seenNbr = false;
-    for (const int label : headLabels()) {
-      if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-        seenNbr = true;
-        ++numAdjHeadNbrs;
-      } else if (seenNbr) {
-        break;
-      }
-    }
-
-    // Check if the tail's neighbors are connected.
-    int numAdjTailNbrs = 0;
-    seenNbr = false;
-    for (const int label : tailLabels()) {
-      if (hasNbrAtLabel(label) && !hasExpHeadAtLabel(label)) {
-        seenNbr = true;
-        ++numAdjTailNbrs;
-      } else if (seenNbr) {
-        break;
-      }
-    }
+    // The head (tail) labels are five consecutive labels starting at the first
+    // head (tail) label, so rotating that label to label 0 leaves exactly the
+    // head's (tail's) neighbors in the lowest five bits.
+    const unsigned int headNbrs =
+        rotateMask(nbrs, -headLabels()[0], 10) & 0x1F;
+    const unsigned int tailNbrs =
+        rotateMask(nbrs, -tailLabels()[0], 10) & 0x1F;
 
     // Property 2 is satisfied if both the head and tail have at least one
     // neighbor and all head (tail) neighbors are connected.
-    return (numHeadNbrs > 0) && (numTailNbrs > 0) &&
-           (numHeadNbrs == numAdjHeadNbrs) && (numTailNbrs == numAdjTailNbrs);
+    return (maskRuns(headNbrs, 10) == 1) && (maskRuns(tailNbrs, 10) == 1);
   }
 }
 
@@ -257,7 +206,11 @@ CompressionSystem::CompressionSystem(int numParticles, double lambda) {
   }
 
   // Set up metrics.
-  _measures.push_back(new PerimeterMeasure("Perimeter", 1, *this));
+  registerMeasure(new PerimeterMeasure("Perimeter", 1, *this));
+}
+
+bool CompressionSystem::supportsParallelActivations() const {
+  return true;
 }
 
 bool CompressionSystem::hasTerminated() const {
@@ -277,8 +230,8 @@ PerimeterMeasure::PerimeterMeasure(const QString name, const unsigned int freq,
 
 double PerimeterMeasure::calculate() const {
   int numEdges = 0;
-  for (const auto& p : _system.particles) {
-    auto comp_p = dynamic_cast<CompressionParticle*>(p);
+  for (unsigned int i = 0; i < _system.size(); ++i) {
+    const CompressionParticle* comp_p = &_system.particle(i);
     auto tailLabels = comp_p->isContracted() ? comp_p->uniqueLabels()
                                              : comp_p->tailLabels();
     for (const int label : tailLabels) {
@@ -14,7 +14,7 @@
 #include <QString>
 
 #include "core/amoebotparticle.h"
-#include "core/amoebotsystem.h"
+#include "core/amoebotsystemt.h"
 
 class CompressionParticle : public AmoebotParticle {
   friend class CompressionSystem;
@@ -54,16 +54,23 @@ private:
   bool hasExpNbr() const;
   bool hasExpHeadAtLabel(const int label) const;
 
-  // Counts the number of neighbors in the labeled positions. Note: this
-  // implicitly assumes all neighbors are unique, as none are expanded.
-  int nbrCount(std::vector<int> labels) const;
+  // Returns the label mask of the positions occupied by neighbors that count
+  // towards this particle's neighborhood, i.e., all neighbors except the heads
+  // of expanded neighbors.
+  unsigned int countedNbrMask() const;
 
-  // Functions for checking Properties 1 and 2 of the compression algorithm.
-  bool checkProp1(std::vector<int> S) const;
-  bool checkProp2(std::vector<int> S) const;
+  // Counts the number of counted neighbors in the positions of the given label
+  // mask. Note: this implicitly assumes all neighbors are unique, as none are
+  // expanded.
+  int nbrCount(unsigned int labels) const;
+
+  // Functions for checking Properties 1 and 2 of the compression algorithm,
+  // given the label mask S and the mask of counted neighbors nbrs.
+  bool checkProp1(unsigned int S, unsigned int nbrs) const;
+  bool checkProp2(unsigned int S, unsigned int nbrs) const;
 };
 
-class CompressionSystem : public AmoebotSystem {
+class CompressionSystem : public AmoebotSystemT<CompressionParticle> {
   friend class PerimeterMeasure;
 
  public:
@@ -75,6 +82,10 @@ class CompressionSystem : public AmoebotSystem {
 
   // Because this algorithm never terminates, this simply returns false.
   virtual bool hasTerminated() const;
+
+  // CompressionParticles only inspect nodes within distance 2 of themselves,
+  // so this returns true.
+  bool supportsParallelActivations() const override;
 };
 
 class PerimeterMeasure : public Measure {
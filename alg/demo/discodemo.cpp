@@ -12,6 +12,8 @@ DiscoDemoParticle::DiscoDemoParticle(const Node& head, const int globalTailDir,
       _counter(counterMax),
       _counterMax(counterMax) {
   _state = getRandColor();
+  _nextState = _state;
+  _nextCounter = _counter;
 }
 
 void DiscoDemoParticle::activate() {
@@ -37,6 +39,32 @@ void DiscoDemoParticle::activate() {
   }
 }
 
+void DiscoDemoParticle::computeNextState() {
+  // Same as activate, but the new counter and color only become visible to the
+  // rest of the system once they are committed.
+  _nextCounter = _counter - 1;
+  _nextState = _state;
+  if (_nextCounter == 0) {
+    _nextCounter = _counterMax;
+    _nextState = getRandColor();
+  }
+
+  if (isContracted()) {
+    int expandDir = randDir();
+    if (canExpand(expandDir)) {
+      requestExpand(expandDir);
+    }
+  } else {  // isExpanded().
+    requestContractTail();
+  }
+}
+
+void DiscoDemoParticle::commitNextState(bool moved) {
+  Q_UNUSED(moved);
+  _counter = _nextCounter;
+  _state = _nextState;
+}
+
 int DiscoDemoParticle::headMarkColor() const {
   switch(_state) {
     case State::Red:    return 0xff0000;
@@ -117,3 +145,11 @@ DiscoDemoSystem::DiscoDemoSystem(unsigned int numParticles, int counterMax) {
     }
   }
 }
+
+bool DiscoDemoSystem::supportsSynchronousRounds() const {
+  return true;
+}
+
+bool DiscoDemoSystem::supportsParallelActivations() const {
+  return true;
+}
@@ -40,6 +40,15 @@ class DiscoDemoParticle : public AmoebotParticle {
   // Executes one particle activation.
   void activate() override;
 
+  // Executes one particle activation in a synchronous round. computeNextState
+  // updates the counter and color like activate, but into the particle's next
+  // state, and requests the movement activate would perform. commitNextState
+  // makes the next state current. Since a particle never reads its neighbors'
+  // states, the only interaction between particles in a round is two particles
+  // requesting to expand into the same node, of which only one succeeds.
+  void computeNextState() override;
+  void commitNextState(bool moved) override;
+
   // Functions for altering the particle's color. headMarkColor() (resp.,
   // tailMarkColor()) returns the color to be used for the ring drawn around the
   // particle's head (resp., tail) node. In this demo, the tail color simply
@@ -59,6 +68,8 @@ class DiscoDemoParticle : public AmoebotParticle {
   State _state;
   int _counter;
   const int _counterMax;
+  State _nextState;
+  int _nextCounter;
 
  private:
   friend class DiscoDemoSystem;
@@ -69,6 +80,11 @@ class DiscoDemoSystem : public AmoebotSystem {
   // Constructs a system of the specified number of DiscoDemoParticles enclosed
   // by a hexagonal ring of objects.
   DiscoDemoSystem(unsigned int numParticles = 30, int counterMax = 5);
+
+  // DiscoDemoParticles implement synchronous rounds and only inspect their
+  // neighbors, so these return true.
+  bool supportsSynchronousRounds() const override;
+  bool supportsParallelActivations() const override;
 };
 
 #endif  // AMOEBOTSIM_ALG_DEMO_DISCODEMO_H_
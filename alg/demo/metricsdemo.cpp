@@ -125,8 +125,8 @@ MetricsDemoSystem::MetricsDemoSystem(unsigned int numParticles, int counterMax)
 
   // Set up metrics.
   _counts.push_back(new Count("# Wall Bumps"));
-  _measures.push_back(new PercentRedMeasure("% Red", 1, *this));
-  _measures.push_back(new MaxDistanceMeasure("Max. Distance", 1, *this));
+  registerMeasure(new PercentRedMeasure("% Red", 1, *this));
+  registerMeasure(new MaxDistanceMeasure("Max. Distance", 1, *this));
 }
 
 PercentRedMeasure::PercentRedMeasure(const QString name,
@@ -7,18 +7,6 @@
 #include <string>
 #include <cstdlib>
 
-//for visualization only
-int maxDistance = 0;
-int numberOfParticles = 0;
-int numberOfTargets = 0;
-int numberOfSources = 0;
-int numberOfCuts = 0;
-int currentId = 1;
-bool globalPortalDone = false;
-bool clear = false;
-int finalized = 0;
-
-
 //helper functions
 bool contains(const std::vector<int>& vec, int num) {
     return std::find(vec.begin(), vec.end(), num) != vec.end();
@@ -84,9 +72,10 @@ ShortestPathForestParticle::ShortestPathForestParticle(const Node &head,
 {
     _source = isSource;
 
-    _distanceSet[X] = isSource && numberOfSources == 1;
-    _distanceSet[Y] = isSource && numberOfSources == 1;
-    _distanceSet[Z] = isSource && numberOfSources == 1;
+    const bool singleSource = spfSystem().numberOfSources == 1;
+    _distanceSet[X] = isSource && singleSource;
+    _distanceSet[Y] = isSource && singleSource;
+    _distanceSet[Z] = isSource && singleSource;
 
     setPortalDistanceFromRoot(X, -1);
     setPortalDistanceFromRoot(Y, -1);
@@ -103,6 +92,8 @@ ShortestPathForestParticle::ShortestPathForestParticle(const Node &head,
 
 void ShortestPathForestParticle::activate()
 {
+    ShortestPathForestSystem& spf = spfSystem();
+
     /*if (numberOfSources == 1) {
         calculatePortalDistance();
         chooseParent();
@@ -110,22 +101,22 @@ void ShortestPathForestParticle::activate()
         prune();
     } else*/
     //std::cout << "start" << std::endl;
-    if (!parentsChosen() && !(finalized == numberOfSources)){
+    if (!parentsChosen() && !(spf.finalized == spf.numberOfSources)){
         //std::cout << "init" << std::endl;
         initializePortalGraph(false, regionId);
         //std::cout << "init után" << std::endl;
        if(_source){
-           if (sendSignal(currentId)) {
-               currentId += 2;
+           if (sendSignal(spf.currentId)) {
+               spf.currentId += 2;
            }
        }
        //std::cout << "signal után" << std::endl;
        if(portalId != -1 && !hasNbrAtLabel(3) && !cutDone){
-            numberOfCuts += cutPortal(true);
+            spf.numberOfCuts += cutPortal(true);
        }
        //std::cout << "cut után" << std::endl;
 
-       if(numberOfCuts == numberOfSources && !regionSplitVisited && portalId  != -1 && _source){
+       if(spf.numberOfCuts == spf.numberOfSources && !regionSplitVisited && portalId  != -1 && _source){
            SplitPropagationMessage msg = {
                .regionId = portalId,
                .sourcesSoFar = 1,
@@ -149,13 +140,13 @@ void ShortestPathForestParticle::activate()
        //std::cout << "region calc split után" << std::endl;
        chooseParent();
        //std::cout << "parent után" << std::endl;
-    } else if (!globalPortalDone && _source){
+    } else if (!spf.globalPortalDone && _source){
         //std::cout << "remove előtt" << std::endl;
         removePortalGraphG();
         //std::cout << "init portal region előtt" << std::endl;
         initializePortalGraphG();
         //std::cout << "init portal region után" << std::endl;
-        globalPortalDone = true;
+        spf.globalPortalDone = true;
     } else if (_source && !sourceDistanceCalculated) {
         //std::cout << "sec portal distance előtt" << std::endl;
         clearSecondaryPortalDistance();
@@ -165,8 +156,8 @@ void ShortestPathForestParticle::activate()
         chooseNewParent();
         //std::cout << "new parent után" << std::endl;
         sourceDistanceCalculated = true;
-        finalized++;
-    } else if (finalized == numberOfSources) {
+        spf.finalized++;
+    } else if (spf.finalized == spf.numberOfSources) {
         //std::cout << "prune előtt" << std::endl;
         prune(regionId);
         //std::cout << "prune után" << std::endl;
@@ -224,11 +215,12 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     }
     //std::cout << "createPortalGraph: check után" << std::endl;
     AxisData axisData = axisMap.at(axis);
+    const unsigned int sameRegionNbrs = sameRegionNbrMask();
     //add main axis
     //std::cout << "createPortalGraph: for1 előtt" << std::endl;
     for(int i = 0; i< 2; ++i) {
         Direction dir = axisData.axis[i];
-        if(hasNbrAtLabel(dir) && nbrAtLabel(dir).regionId == regionId) {
+        if(sameRegionNbrs & (1u << dir)) {
             pushPortalDirections(axis, dir);
         }
     }
@@ -238,10 +230,10 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     //std::cout << "createPortalGraph: if előtt" << std::endl;
     if (neighbourExists(axis, axisData.boundaryDirection)) {
         //we check if the parallel amoebots are on the boundary, if so we connect them
-        if (!hasNbrAtLabel(axisData.sideA[0]) && hasNbrAtLabel(axisData.sideA[1]) && nbrAtLabel(axisData.sideA[1]).regionId == regionId) {
+        if (!hasNbrAtLabel(axisData.sideA[0]) && (sameRegionNbrs & (1u << axisData.sideA[1]))) {
             pushPortalDirections(axis, axisData.sideA[1]);
         }
-        if (!hasNbrAtLabel(axisData.sideB[0]) && hasNbrAtLabel(axisData.sideB[1]) && nbrAtLabel(axisData.sideB[1]).regionId == regionId) {
+        if (!hasNbrAtLabel(axisData.sideB[0]) && (sameRegionNbrs & (1u << axisData.sideB[1]))) {
             pushPortalDirections(axis, axisData.sideB[1]);
         }
         return;
@@ -253,7 +245,7 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     //std::cout << "createPortalGraph: for2 előtt" << std::endl;
     for(int i = 0; i< 2; ++i) {
         Direction dir = axisData.sideA[i];
-        if(hasNbrAtLabel(dir) && nbrAtLabel(dir).regionId == regionId) {
+        if(sameRegionNbrs & (1u << dir)) {
             pushPortalDirections(axis, dir);
             break;
         }
@@ -262,7 +254,7 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     //sideB
     for(int i = 0; i< 2; ++i) {
         Direction dir = axisData.sideB[i];
-        if(hasNbrAtLabel(dir) && nbrAtLabel(dir).regionId == regionId) {
+        if(sameRegionNbrs & (1u << dir)) {
             pushPortalDirections(axis, dir);
             break;
         }
@@ -270,7 +262,7 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     //std::cout << "createPortalGraph: for3 után" << std::endl;
 
     for (int i = 0; i < 6; ++i) {
-        if(hasNbrAtLabel(i) && nbrAtLabel(i).regionId == regionId) {
+        if(sameRegionNbrs & (1u << i)) {
             //std::cout << "createPortalGraph: propageate i: " << i << " exists: "<< hasNbrAtLabel(i) << std::endl;
             nbrAtLabel(i).createPortalGraph(axis);
             //std::cout << "createPortalGraph: propageate után" << std::endl;
@@ -279,6 +271,13 @@ void ShortestPathForestParticle::createPortalGraph(Axis axis) {
     //std::cout << "createPortalGraph: vége" << std::endl;
 }
 
+unsigned int ShortestPathForestParticle::sameRegionNbrMask() const {
+    return nbrMaskWithProperty<ShortestPathForestParticle>(
+        [this](const ShortestPathForestParticle& nbr) {
+            return nbr.regionId == regionId;
+        });
+}
+
 
 
 void ShortestPathForestParticle::calculatePortalDistance() {
@@ -311,7 +310,7 @@ void ShortestPathForestParticle::chooseParent() {
     }
     // For visualization only
     int distance = (getPortalDistanceFromRoot(X) + getPortalDistanceFromRoot(Y) + getPortalDistanceFromRoot(Z)) / 2;
-    if (distance > maxDistance) maxDistance = distance;
+    if (distance > spfSystem().maxDistance) spfSystem().maxDistance = distance;
     //For visualization only
     for (int dir = EAST; dir <= SOUTHEAST; dir += 1) {
         if (hasNbrAtLabel(dir) && nbrAtLabel(dir).regionId == regionId) {
@@ -327,6 +326,10 @@ void ShortestPathForestParticle::chooseParent() {
 }
 
 
+ShortestPathForestSystem& ShortestPathForestParticle::spfSystem() const {
+    return static_cast<ShortestPathForestSystem&>(system);
+}
+
 ShortestPathForestParticle& ShortestPathForestParticle::nbrAtLabel(int label) const {
     return AmoebotParticle::nbrAtLabel<ShortestPathForestParticle>(label);
 }
@@ -508,15 +511,7 @@ ShortestPathForestSystem::ShortestPathForestSystem(int numParticles, int sourceC
 {
     //For visualization only
     int grid_size = 40;
-    maxDistance = 0;
-    numberOfTargets = targetCount;
-    numberOfParticles = numParticles;
     numberOfSources = sourceCount;
-    numberOfCuts = 0;
-    globalPortalDone = false;
-    globalPortalDone = false;
-    clear = false;
-    finalized = 0;
     //For visualization only
     std::set<Node> occupied;
     occupied.insert(Node(grid_size/2,grid_size/2 ));
@@ -595,10 +590,9 @@ ShortestPathForestSystem::ShortestPathForestSystem(int numParticles, int sourceC
     std::vector<int> indices(numParticles);
     std::iota(indices.begin(), indices.end(), 0); // [0, 1, ..., numParticles-1]
 
-    // Shuffle
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::shuffle(indices.begin(), indices.end(), gen);
+    // Shuffle with the system's engine so that the choice of sources and
+    // targets is reproducible from the system's seed.
+    shuffle(indices.begin(), indices.end());
 
     // Pick targets
     std::vector<int> sourceIndices(indices.begin(), indices.begin() + sourceCount);
@@ -15,7 +15,7 @@
 #include <QString>
 
 #include "core/amoebotparticle.h"
-#include "core/amoebotsystem.h"
+#include "core/amoebotsystemt.h"
 #include <iostream>
 #include <vector>
 #include <map>
@@ -68,15 +68,20 @@ struct SplitPropagationMessage {
     int originPortalId;
 };
 
+// ShortestPathForestSystem must be forward declared so that particles can
+// access the algorithm-wide state it holds.
+class ShortestPathForestSystem;
+
 class ShortestPathForestParticle : public AmoebotParticle {
 public:
     std::string groupId[2];
 
     std::string generate_uuid() {
-        static thread_local std::mt19937_64 rng(std::random_device{}());
-        static thread_local std::uniform_int_distribution<uint64_t> dist(0, 0xFFFFFFFFFFFFFFFF);
+        // Draw from the system's engine so that ids are reproducible from the
+        // system's seed.
+        std::uniform_int_distribution<uint64_t> dist(0, 0xFFFFFFFFFFFFFFFF);
 
-        auto rand64 = []() { return dist(rng); };
+        auto rand64 = [&dist]() { return dist(engine()); };
 
         uint64_t part1 = rand64();
         uint64_t part2 = rand64();
@@ -405,11 +410,13 @@ public:
 
     void setHasSourceOnPortal(int value){
         portalId = value;
+        system.markChanged(*this);
     }
 
     bool sendSignal(int id){
         if (portalId != -1) return false;
         portalId = id;
+        system.markChanged(*this);
         if(hasNbrAtLabel(0) && nbrAtLabel(0).portalId == -1){
             nbrAtLabel(0).sendSignal(id);
         }
@@ -508,6 +515,7 @@ public:
                         _portalDistanceFromRoot[Z] = _secondaryPortalDistanceFromRoot.at(Z);
                         parent = static_cast<Direction>(dir);
                         _headMarkDir = dir;
+                        system.markChanged(*this);
                     }
                 }
             }
@@ -529,6 +537,7 @@ public:
 
         regionId = msg.regionId;
         regionSplitVisited = true;
+        system.markChanged(*this);
 
         SplitPropagationMessage nextMsg = {
             msg.regionId,
@@ -610,6 +619,7 @@ public:
     void rootPruning() {
         noTargetinPath();
         visited = true;
+        system.markChanged(*this);
         int potentialdirection[6]={0,1,2,3,4,5};
         for(int pot : potentialdirection){
             if (hasNbrAtLabel(pot) && !nbrAtLabel(pot).visited){
@@ -626,6 +636,7 @@ public:
                 outedge[i] = -1; // this means the we cut the edges between in this
             }
         }
+        system.markChanged(*this);
     }
 
     int getInedge(int index) const {
@@ -634,6 +645,7 @@ public:
 
     void setInedge(int index,int value){
         inedge[index]= value;
+        system.markChanged(*this);
     }
 
     int getOutedge(int index) const {
@@ -642,6 +654,7 @@ public:
 
     void setOutedge(int index,int value){
         outedge[index]= value;
+        system.markChanged(*this);
     }
 
     void visibility(std::set<ShortestPathForestParticle>& P){
@@ -751,10 +764,16 @@ private:
     int distance = 0;
     ShortestPathForestParticle* propparent;
 
+    // Returns the system this particle belongs to, which holds the state shared
+    // by all particles of a run.
+    ShortestPathForestSystem& spfSystem() const;
+
     void calculatePortalDistance();
     void chooseParent();
     void prune(int originalRegionId);
     void createPortalGraph(Axis axis);
+    // Returns the label mask of the neighbors in this particle's region.
+    unsigned int sameRegionNbrMask() const;
     void initializePortalGraph(bool clear, int regionId);
     void removePortalGraph(int regionId);
     Direction chooseClosestToSource(std::vector<Direction>);
@@ -769,12 +788,25 @@ private:
     std::map<Axis,bool> _distanceSet; //distance from root set by neighbour
 };
 
-class ShortestPathForestSystem : public AmoebotSystem {
+class ShortestPathForestSystem : public AmoebotSystemT<ShortestPathForestParticle> {
 public:
     // Constructs a system of the specified number of PortalGraphDemoParticles.
     ShortestPathForestSystem(int numParticles = 30,
                       int sourceCount = 1,
                       int targetCount = 1);
+
+private:
+    friend class ShortestPathForestParticle;
+
+    // Algorithm-wide state shared by all particles of this system. It is kept
+    // per system rather than in globals so that independent systems (e.g.,
+    // replicas running on different threads) do not interfere.
+    int maxDistance = 0;  // For visualization only.
+    int numberOfSources;
+    int numberOfCuts = 0;
+    int currentId = 1;
+    bool globalPortalDone = false;
+    int finalized = 0;
 };
 
 bool dfsPathExists(const std::set<Node>& graph, const Node& start, const Node& target,std::set<Node>& visited);
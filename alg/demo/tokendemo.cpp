@@ -4,6 +4,8 @@
 
 #include "alg/demo/tokendemo.h"
 
+#include <algorithm>
+
 TokenDemoParticle::TokenDemoParticle(const Node& head, const int globalTailDir,
                                      const int orientation,
                                      AmoebotSystem& system)
@@ -96,10 +98,12 @@ TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime) {
       if (hexNode.x == 0 && hexNode.y == 0) {
         auto firstP = new TokenDemoParticle(Node(0, 0), -1, randDir(), *this);
         for (int j = 0; j < 5; ++j) {
-          auto redToken = std::make_shared<TokenDemoParticle::RedToken>();
+          auto redToken =
+              TokenDemoParticle::makeToken<TokenDemoParticle::RedToken>();
           redToken->_lifetime = lifetime;
           firstP->putToken(redToken);
-          auto blueToken = std::make_shared<TokenDemoParticle::BlueToken>();
+          auto blueToken =
+              TokenDemoParticle::makeToken<TokenDemoParticle::BlueToken>();
           blueToken->_lifetime = lifetime;
           firstP->putToken(blueToken);
         }
@@ -111,6 +115,10 @@ TokenDemoSystem::TokenDemoSystem(int numParticles, int lifetime) {
       hexNode = hexNode.nodeInDir(dir);
     }
   }
+
+  // Detecting that all tokens have died out requires scanning every particle,
+  // so only check for termination once per particle's worth of activations.
+  setTerminationCheckInterval(std::max<unsigned int>(1, particles.size()));
 }
 
 bool TokenDemoSystem::hasTerminated() const {
@@ -59,7 +59,8 @@ class TokenDemoSystem : public AmoebotSystem {
   TokenDemoSystem(int numParticles = 48, int lifetime = 100);
 
   // Returns true when the simulation has completed; i.e, when all tokens have
-  // died out.
+  // died out. This scans all particles, so the system raises its termination
+  // check interval to the number of particles.
   bool hasTerminated() const override;
 };
 
@@ -4,6 +4,8 @@
 
 #include "alg/edfhexagonformation.h"
 
+#include <algorithm>
+
 EDFHexagonFormationParticle::EDFHexagonFormationParticle(
     const Node head,
     AmoebotSystem& system,
@@ -15,10 +17,10 @@ EDFHexagonFormationParticle::EDFHexagonFormationParticle(
       _capacity(capacity),
       _transferRate(transferRate),
       _demand(demand),
-      _eState(EnergyState::Idle),
+      _eState(system.getStateTally("Energy State"), EnergyState::Idle),
       _eParentLabel(-1),
       _battery(0),
-      _sState(sState),
+      _sState(system.getStateTally("Shape State"), sState),
       _sParentDir(-1),
       _hexagonDir(sState == ShapeState::Seed ? 0 : -1) {}
 
@@ -399,7 +401,9 @@ EDFHexagonFormationSystem::EDFHexagonFormationSystem(int numParticles,
                                                      double holeProb,
                                                      int capacity,
                                                      int transferRate,
-                                                     int demand) {
+                                                     int demand)
+    : _eStateTally(registerStateTally("Energy State")),
+      _sStateTally(registerStateTally("Shape State")) {
   // Insert the shape formation seed at (0,0).
   std::set<Node> occupied;
   insert(new EDFHexagonFormationParticle(
@@ -460,23 +464,28 @@ EDFHexagonFormationSystem::EDFHexagonFormationSystem(int numParticles,
     auto ehp = dynamic_cast<EDFHexagonFormationParticle*>(particles[indices[i]]);
     ehp->_eState = EDFHexagonFormationParticle::EnergyState::Source;
   }
+
+  // Batteries are not tallied, so once the state conditions hold, each check
+  // scans every particle; only check once per particle's worth of activations.
+  setTerminationCheckInterval(std::max<unsigned int>(1, particles.size()));
 }
 
 bool EDFHexagonFormationSystem::hasTerminated() const {
-  // Check if all amoebots are in the spanning forest and have full batteries.
-  for (auto p : particles) {
-    auto ehp = dynamic_cast<EDFHexagonFormationParticle*>(p);
-    if (ehp->_eState == EDFHexagonFormationParticle::EnergyState::Idle
-        || ehp->_eState == EDFHexagonFormationParticle::EnergyState::Pruning
-        || ehp->_battery < ehp->_capacity)
-      return false;
-  }
+  // Check that all amoebots are in the spanning forest.
+  if (_eStateTally.count(EDFHexagonFormationParticle::EnergyState::Idle) > 0
+      || _eStateTally.count(EDFHexagonFormationParticle::EnergyState::Pruning)
+         > 0)
+    return false;
 
   // Check that all particles are either the seed or retired.
+  if (!_sStateTally.allIn({EDFHexagonFormationParticle::ShapeState::Seed,
+                           EDFHexagonFormationParticle::ShapeState::Retired}))
+    return false;
+
+  // Check that all amoebots have full batteries.
   for (auto p : particles) {
     auto ehp = dynamic_cast<EDFHexagonFormationParticle*>(p);
-    if (ehp->_sState != EDFHexagonFormationParticle::ShapeState::Seed
-        && ehp->_sState != EDFHexagonFormationParticle::ShapeState::Retired)
+    if (ehp->_battery < ehp->_capacity)
       return false;
   }
 
@@ -119,13 +119,15 @@ class EDFHexagonFormationParticle : public AmoebotParticle {
   const int _transferRate;
   const int _demand;
 
-  // Energy distribution framework variables.
-  EnergyState _eState;
+  // Energy distribution framework variables. _eState is tracked in the
+  // system's "Energy State" tally.
+  TrackedState<EnergyState> _eState;
   int _eParentLabel;
   double _battery;
 
-  // Hexagon-Formation variables.
-  ShapeState _sState;
+  // Hexagon-Formation variables. _sState is tracked in the system's "Shape
+  // State" tally.
+  TrackedState<ShapeState> _sState;
   int _sParentDir;
   int _hexagonDir;
 
@@ -145,8 +147,14 @@ class EDFHexagonFormationSystem : public AmoebotSystem {
 
   // Checks whether all particles belong to the energy distribution spanning
   // forest, all particles have fully recharged, and the system has formed a
-  // hexagon (i.e., all particles are in ShapeState::Retired).
+  // hexagon (i.e., all particles are in ShapeState::Retired). The state
+  // conditions are checked in constant time using the state tallies; only
+  // when they hold are the particles' batteries scanned.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _eStateTally;
+  StateTally& _sStateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_EDFHEXAGONFORMATION_H_
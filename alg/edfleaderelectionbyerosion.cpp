@@ -4,6 +4,8 @@
 
 #include "alg/edfleaderelectionbyerosion.h"
 
+#include <algorithm>
+
 EDFLeaderElectionByErosionParticle::EDFLeaderElectionByErosionParticle(
     const Node head,
     AmoebotSystem& system,
@@ -14,10 +16,10 @@ EDFLeaderElectionByErosionParticle::EDFLeaderElectionByErosionParticle(
       _capacity(capacity),
       _transferRate(transferRate),
       _demand(demand),
-      _eState(EnergyState::Idle),
+      _eState(system.getStateTally("Energy State"), EnergyState::Idle),
       _eParentDir(-1),
       _battery(0),
-      _lState(LeaderState::Null) {}
+      _lState(system.getStateTally("Leader State"), LeaderState::Null) {}
 
 void EDFLeaderElectionByErosionParticle::activate() {
   // Prioritize Leader-Election-By-Erosion actions over energy distribution.
@@ -310,7 +312,9 @@ EDFLeaderElectionByErosionSystem::EDFLeaderElectionByErosionSystem(
     int numEnergySources,
     int capacity,
     int transferRate,
-    int demand) {
+    int demand)
+    : _eStateTally(registerStateTally("Energy State")),
+      _lStateTally(registerStateTally("Leader State")) {
   // Create a hexagon of EnergyState::Idle particles.
   int x, y;
   for (int i = 1; i <= numParticles; ++i) {
@@ -370,24 +374,30 @@ EDFLeaderElectionByErosionSystem::EDFLeaderElectionByErosionSystem(
         particles[indices[i]]);
     elp->_eState = EDFLeaderElectionByErosionParticle::EnergyState::Source;
   }
+
+  // Batteries are not tallied, so once a leader has emerged, each check scans
+  // every particle; only check once per particle's worth of activations.
+  setTerminationCheckInterval(std::max<unsigned int>(1, particles.size()));
 }
 
 bool EDFLeaderElectionByErosionSystem::hasTerminated() const {
-  // Check if all amoebots are in the spanning forest and have full batteries.
-  for (auto p : particles) {
-    auto elp = dynamic_cast<EDFLeaderElectionByErosionParticle*>(p);
-    if (elp->_eState == EDFLeaderElectionByErosionParticle::EnergyState::Idle
-        || elp->_eState == EDFLeaderElectionByErosionParticle::EnergyState::Pruning
-        || elp->_battery < elp->_capacity)
-      return false;
-  }
+  // Check that all amoebots are in the spanning forest.
+  using EnergyState = EDFLeaderElectionByErosionParticle::EnergyState;
+  if (_eStateTally.count(EnergyState::Idle) > 0
+      || _eStateTally.count(EnergyState::Pruning) > 0)
+    return false;
 
   // Check that a leader has emerged.
+  using LeaderState = EDFLeaderElectionByErosionParticle::LeaderState;
+  if (_lStateTally.count(LeaderState::Leader) == 0)
+    return false;
+
+  // Check that all amoebots have full batteries.
   for (auto p : particles) {
     auto elp = dynamic_cast<EDFLeaderElectionByErosionParticle*>(p);
-    if (elp->_lState == EDFLeaderElectionByErosionParticle::LeaderState::Leader)
-      return true;
+    if (elp->_battery < elp->_capacity)
+      return false;
   }
 
-  return false;
+  return true;
 }
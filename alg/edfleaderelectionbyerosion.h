@@ -99,13 +99,15 @@ class EDFLeaderElectionByErosionParticle : public AmoebotParticle {
   const int _transferRate;
   const int _demand;
 
-  // Energy distribution framework variables.
-  EnergyState _eState;
+  // Energy distribution framework variables. _eState is tracked in the
+  // system's "Energy State" tally.
+  TrackedState<EnergyState> _eState;
   int _eParentDir;
   double _battery;
 
-  // Leader-Election-By-Erosion variables.
-  LeaderState _lState;
+  // Leader-Election-By-Erosion variables. _lState is tracked in the system's
+  // "Leader State" tally.
+  TrackedState<LeaderState> _lState;
 
  private:
   friend class EDFLeaderElectionByErosionSystem;
@@ -123,8 +125,14 @@ class EDFLeaderElectionByErosionSystem : public AmoebotSystem {
 
   // Checks whether all particles belong to the energy distribution spanning
   // forest, all particles have fully recharged, and the system has elected a
-  // leader (i.e., there exists a particle in LeaderState::Leader).
+  // leader (i.e., there exists a particle in LeaderState::Leader). The state
+  // conditions are checked in constant time using the state tallies; only
+  // when they hold are the particles' batteries scanned.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _eStateTally;
+  StateTally& _lStateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_EDFLEADERELECTIONBYEROSION_H_
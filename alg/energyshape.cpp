@@ -26,10 +26,11 @@ EnergyShapeParticle::EnergyShapeParticle(const Node& head, int globalTailDir,
       _eState(eState),
       _parentLabel(-1),
       _lastParent(0),
-      _sState(sState),
+      _sState(system.getStateTally("Shape State"), sState),
       _constructionDir(-1),
       _moveDir(-1),
-      _followDir(-1) {
+      _followDir(-1),
+      _actionsCount(system.countHandle("# Actions")) {
   if (_sState == ShapeState::Seed) {
     _constructionDir = 0;
   }
@@ -279,7 +280,7 @@ void EnergyShapeParticle::useEnergy() {
 
     if (didAction) {
       _battery -= _demand;
-      system.getCount("# Actions").record();
+      _actionsCount.record();
     }
   }
 }
@@ -374,8 +375,9 @@ EnergyShapeSystem::EnergyShapeSystem(const int numParticles,
                                      const double holeProb,
                                      const double capacity,
                                      const double demand,
-                                     const double transferRate) {
-  _counts.push_back(new Count("# Actions"));
+                                     const double transferRate)
+    : _sStateTally(registerStateTally("Shape State")) {
+  registerCount("# Actions");
 
   // Insert the energy distribution root/shape formation seed at (0,0).
   std::set<Node> occupied;
@@ -438,14 +440,21 @@ EnergyShapeSystem::EnergyShapeSystem(const int numParticles,
     auto esp = dynamic_cast<EnergyShapeParticle*>(particles[indices[i]]);
     esp->_eState = EnergyShapeParticle::EnergyState::Root;
   }
+
+  // Finding stressed or inhibited particles takes a scan, which would otherwise
+  // run after every activation once the shape is finished.
+  setTerminationCheckInterval(std::max<unsigned int>(1, particles.size()));
 }
 
 bool EnergyShapeSystem::hasTerminated() const {
+  if (!_sStateTally.allIn({EnergyShapeParticle::ShapeState::Seed,
+                           EnergyShapeParticle::ShapeState::Finish})) {
+    return false;
+  }
+
   for (auto p : particles) {
     auto esp = dynamic_cast<EnergyShapeParticle*>(p);
-    if (esp->_stress || esp->_inhibit ||
-        (esp->_sState != EnergyShapeParticle::ShapeState::Seed
-         && esp->_sState != EnergyShapeParticle::ShapeState::Finish)) {
+    if (esp->_stress || esp->_inhibit) {
       return false;
     }
   }
@@ -125,12 +125,16 @@ class EnergyShapeParticle : public AmoebotParticle {
   int _parentLabel;
   int _lastParent;
 
-  // Shape Formation variables.
-  ShapeState _sState;
+  // Shape Formation variables. _sState is tracked in the system's "Shape
+  // State" tally.
+  TrackedState<ShapeState> _sState;
   int _constructionDir;
   int _moveDir;
   int _followDir;
 
+  // Handle to the system's "# Actions" count, resolved once at construction.
+  CountHandle _actionsCount;
+
  private:
   friend class EnergyShapeSystem;
 };
@@ -146,8 +150,12 @@ class EnergyShapeSystem : public AmoebotSystem {
                     const double demand, const double transferRate);
 
   // Checks whether the system has completed forming the desired shape (i.e.,
-  // all particles are in shape state Finish).
+  // all particles are in shape state Finish). Only scans the particles for
+  // stress and inhibition once _sStateTally shows the shape is complete.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _sStateTally;
 };
 
 #endif  // ALG_ENERGYSHAPE_H_
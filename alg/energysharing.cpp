@@ -23,6 +23,7 @@ EnergySharingParticle::EnergySharingParticle(const Node& head,
       _battery(0),
       _stress(false),
       _inhibit(false),
+      _actionsCount(system.countHandle("# Actions")),
       _state(state),
       _parentLabel(-1) {}
 
@@ -154,7 +155,7 @@ void EnergySharingParticle::useEnergy() {
   if (!_inhibit && _battery >= _demand) {
     if (_usage == Usage::Uniform) {
       _battery -= _demand;
-      system.getCount("# Actions").record();
+      _actionsCount.record();
     } else if (_usage == Usage::Reproduce) {
       int reproduceDir = -1;
       for (int dir = 0; dir < 6; dir++) {
@@ -166,7 +167,7 @@ void EnergySharingParticle::useEnergy() {
 
       if (reproduceDir != -1) {
         _battery -= _demand;
-        system.getCount("# Actions").record();
+        _actionsCount.record();
         system.insert(new EnergySharingParticle(
                         head.nodeInDir(localToGlobalDir(reproduceDir)), -1,
                         randDir(), system, _capacity, _demand, _transferRate,
@@ -204,7 +205,7 @@ EnergySharingSystem::EnergySharingSystem(int numParticles,
                                          const double capacity,
                                          const double demand,
                                          const double transferRate) {
-  _counts.push_back(new Count("# Actions"));
+  registerCount("# Actions");
 
   // Add a hexagon of idle particles to the system.
   int x, y;
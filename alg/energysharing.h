@@ -82,6 +82,9 @@ class EnergySharingParticle : public AmoebotParticle {
   bool _stress;
   bool _inhibit;
 
+  // Handle to the system's "# Actions" count, resolved once at construction.
+  CountHandle _actionsCount;
+
   // Spanning tree variables.
   State _state;
   int _parentLabel;
@@ -8,7 +8,7 @@ HexagonFormationParticle::HexagonFormationParticle(const Node head,
                                                    AmoebotSystem& system,
                                                    const State state)
     : AmoebotParticle(head, -1, randDir(), system),
-      _state(state),
+      _state(system.getStateTally("State"), state),
       _parentDir(-1),
       _hexagonDir(state == State::Seed ? 0 : -1) {}
 
@@ -200,7 +200,8 @@ const std::vector<int> HexagonFormationParticle::conTailChildLabels() const {
 }
 
 HexagonFormationSystem::HexagonFormationSystem(int numParticles,
-                                               double holeProb) {
+                                               double holeProb)
+    : _stateTally(registerStateTally("State")) {
   // Insert the shape formation seed at (0,0).
   std::set<Node> occupied;
   insert(new HexagonFormationParticle(Node(0, 0), *this,
@@ -247,12 +248,6 @@ HexagonFormationSystem::HexagonFormationSystem(int numParticles,
 }
 
 bool HexagonFormationSystem::hasTerminated() const {
-  for (auto p : particles) {
-    auto hp = dynamic_cast<HexagonFormationParticle*>(p);
-    if (hp->_state != HexagonFormationParticle::State::Seed
-        && hp->_state != HexagonFormationParticle::State::Retired)
-      return false;
-  }
-
-  return true;
+  return _stateTally.allIn({HexagonFormationParticle::State::Seed,
+                            HexagonFormationParticle::State::Retired});
 }
@@ -15,7 +15,7 @@
 #define AMOEBOTSIM_ALG_HEXAGONFORMATION_H_
 
 #include "core/amoebotparticle.h"
-#include "core/amoebotsystem.h"
+#include "core/amoebotsystemt.h"
 
 class HexagonFormationParticle : public AmoebotParticle {
  public:
@@ -82,8 +82,8 @@ class HexagonFormationParticle : public AmoebotParticle {
   const std::vector<int> conTailChildLabels() const;
 
  protected:
-  // Particle memory.
-  State _state;
+  // Particle memory. _state is tracked in the system's "State" tally.
+  TrackedState<State> _state;
   int _parentDir;   // Corresponds to "parent" in paper.
   int _hexagonDir;  // Corresponds to "dir" in paper.
 
@@ -91,7 +91,7 @@ class HexagonFormationParticle : public AmoebotParticle {
   friend class HexagonFormationSystem;
 };
 
-class HexagonFormationSystem : public AmoebotSystem {
+class HexagonFormationSystem : public AmoebotSystemT<HexagonFormationParticle> {
  public:
   // Constructs a system of HexagonFormationParticles with an optionally
   // specified size (#particles) and hole probability in [0,1) controlling how
@@ -99,8 +99,11 @@ class HexagonFormationSystem : public AmoebotSystem {
   HexagonFormationSystem(int numParticles = 200, double holeProb = 0.2);
 
   // Checks whether the system has formed a hexagon (i.e., all particles are in
-  // State::Seed or State::Retired).
+  // State::Seed or State::Retired). Runs in constant time using _stateTally.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _stateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_HEXAGONFORMATION_H_
@@ -4,6 +4,7 @@
 
 #include "alg/infobjcoating.h"
 
+#include <algorithm>
 #include <set>
 
 InfObjCoatingParticle::InfObjCoatingParticle(const Node head,
@@ -11,7 +12,7 @@ InfObjCoatingParticle::InfObjCoatingParticle(const Node head,
                                              const int orientation,
                                              AmoebotSystem &system, State state)
   : AmoebotParticle(head, globalTailDir, orientation, system),
-    state(state),
+    state(system.getStateTally("State"), state),
     moveDir(-1) {}
 
 void InfObjCoatingParticle::activate() {
@@ -63,7 +64,7 @@ void InfObjCoatingParticle::activate() {
     } else if (state == State::Leader) {
       // If has a follower child, generate a complaint token if not holding one.
       if (hasFollowerChild() && !hasToken<ComplaintToken>()) {
-        putToken(std::make_shared<ComplaintToken>());
+        putToken(makeToken<ComplaintToken>());
       }
 
       // Only act if holding a complaint token.
@@ -182,7 +183,8 @@ bool InfObjCoatingParticle::hasFollowerChild() const {
   return labelOfFirstNbrWithProperty<InfObjCoatingParticle>(prop) != -1;
 }
 
-InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb) {
+InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb)
+    : _stateTally(registerStateTally("State")) {
   Q_ASSERT(numParticles > 0);
   Q_ASSERT(0 <= holeProb && holeProb <= 1);
 
@@ -250,15 +252,22 @@ InfObjCoatingSystem::InfObjCoatingSystem(uint numParticles, double holeProb) {
       }
     }
   }
+
+  // Leftover complaint tokens can only be found by scanning the particles, so
+  // check for termination once per particle's worth of activations.
+  setTerminationCheckInterval(std::max<unsigned int>(1, particles.size()));
 }
 
 bool InfObjCoatingSystem::hasTerminated() const {
   // Algorithm is terminated if all particles are on the surface (leaders) and
   // have contracted.
+  if (!_stateTally.allIn({InfObjCoatingParticle::State::Leader})) {
+    return false;
+  }
+
   for (auto p : particles) {
     auto iocp = dynamic_cast<InfObjCoatingParticle*>(p);
-    if ((iocp->state != InfObjCoatingParticle::State::Leader) ||
-        iocp->hasToken<InfObjCoatingParticle::ComplaintToken>()) {
+    if (iocp->hasToken<InfObjCoatingParticle::ComplaintToken>()) {
       return false;
     }
   }
@@ -75,8 +75,8 @@ class InfObjCoatingParticle : public AmoebotParticle {
   // object's surface forever.
   struct ComplaintToken : public Token {};
 
-  // Particle memory.
-  State state;
+  // Particle memory. state is tracked in the system's "State" tally.
+  TrackedState<State> state;
   int moveDir;
 
  private:
@@ -93,8 +93,12 @@ class InfObjCoatingSystem : public AmoebotSystem {
   InfObjCoatingSystem(uint numParticles = 100, double holeProb = 0.2);
 
   // Checks whether or not the system has completed infinite object coating (all
-  // particles contracted and on the object.
+  // particles contracted and on the object. Only scans the particles for
+  // pending complaints once _stateTally shows that all of them are leaders.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _stateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_INFOBJCOATING_H_
@@ -16,7 +16,7 @@ LeaderElectionParticle::LeaderElectionParticle(const Node head,
                                                AmoebotSystem& system,
                                                State state)
   : AmoebotParticle(head, globalTailDir, orientation, system),
-    state(state),
+    state(system.getStateTally("State"), state),
     currentAgent(0) {
   borderColorLabels.fill(-1);
   borderPointColorLabels.fill(-1);
@@ -247,7 +247,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         takeAgentToken<SegmentLeadToken>(prevAgentDir);
         passAgentToken<PassiveSegmentToken>
             (prevAgentDir,
-             std::make_shared<PassiveSegmentToken>(-1, true));
+             makeToken<PassiveSegmentToken>(-1, true));
         paintBackSegment(0x696969);
       }
     }
@@ -261,16 +261,16 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
           takeAgentToken<ActiveSegmentToken>(nextAgentDir);
           passAgentToken<FinalSegmentCleanToken>
               (nextAgentDir,
-               std::make_shared<FinalSegmentCleanToken>(-1, true));
+               makeToken<FinalSegmentCleanToken>(-1, true));
         } else if (next != nullptr &&
                    !next->hasAgentToken<PassiveSegmentCleanToken>
                    (next->prevAgentDir)) {
           passAgentToken<PassiveSegmentCleanToken>
-              (nextAgentDir, std::make_shared<PassiveSegmentCleanToken>());
+              (nextAgentDir, makeToken<PassiveSegmentCleanToken>());
           passiveClean(true);
           generatedCleanToken = true;
           candidateParticle->putToken
-              (std::make_shared<ActiveSegmentCleanToken>(nextAgentDir));
+              (makeToken<ActiveSegmentCleanToken>(nextAgentDir));
           activeClean(true);
           absorbedActiveToken = true;
           isCoveredCandidate = true;
@@ -281,7 +281,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       } else {
         Q_ASSERT(false);
         passAgentToken<ActiveSegmentToken>
-            (prevAgentDir, std::make_shared<ActiveSegmentToken>());
+            (prevAgentDir, makeToken<ActiveSegmentToken>());
       }
     }
 
@@ -290,7 +290,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         passTokensDir == 1) {
       takeAgentToken<CandidacyAnnounceToken>(prevAgentDir);
       passAgentToken<CandidacyAckToken>
-          (prevAgentDir, std::make_shared<CandidacyAckToken>());
+          (prevAgentDir, makeToken<CandidacyAckToken>());
       paintBackSegment(0x696969);
       if (waitingForTransferAck) {
         gotAnnounceBeforeAck = true;
@@ -341,7 +341,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
               takeAgentToken<PassiveSegmentToken>(nextAgentDir)->isFinal;
           passAgentToken<ActiveSegmentToken>
               (prevAgentDir,
-               std::make_shared<ActiveSegmentToken>(-1, isFinalCheck));
+               makeToken<ActiveSegmentToken>(-1, isFinalCheck));
           if (isFinalCheck) {
             paintFrontSegment(0x696969);
           }
@@ -362,7 +362,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         return;
       } else if (!comparingSegment && passTokensDir == 0) {
         passAgentToken<SegmentLeadToken>
-            (nextAgentDir, std::make_shared<SegmentLeadToken>());
+            (nextAgentDir, makeToken<SegmentLeadToken>());
         paintFrontSegment(0xff0000);
         comparingSegment = true;
       }
@@ -381,16 +381,16 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
         return;
       } else if (!waitingForTransferAck && passTokensDir == 0 && randBool()) {
         passAgentToken<CandidacyAnnounceToken>
-            (nextAgentDir, std::make_shared<CandidacyAnnounceToken>());
+            (nextAgentDir, makeToken<CandidacyAnnounceToken>());
         paintFrontSegment(0xffa500);
         waitingForTransferAck = true;
       }
     } else if (subPhase == SubPhase::SolitudeVerification) {
       if (!createdLead && passTokensDir == 0) {
         passAgentToken<SolitudeActiveToken>
-            (nextAgentDir, std::make_shared<SolitudeActiveToken>());
+            (nextAgentDir, makeToken<SolitudeActiveToken>());
         candidateParticle->putToken
-            (std::make_shared<SolitudePositiveXToken>(nextAgentDir, true));
+            (makeToken<SolitudePositiveXToken>(nextAgentDir, true));
         paintFrontSegment(0x00bfff);
         createdLead = true;
         hasGeneratedTokens = true;
@@ -458,7 +458,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       passAgentToken<SegmentLeadToken>
           (nextAgentDir, takeAgentToken<SegmentLeadToken>(prevAgentDir));
       candidateParticle->putToken(
-            std::make_shared<PassiveSegmentToken>(nextAgentDir, false));
+            makeToken<PassiveSegmentToken>(nextAgentDir, false));
       paintBackSegment(0xff0000);
       paintFrontSegment(0xff0000);
     }
@@ -476,7 +476,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
       if (passTokensDir == 0 && !absorbedActiveToken) {
         if (takeAgentToken<ActiveSegmentToken>(nextAgentDir)->isFinal) {
           passAgentToken<FinalSegmentCleanToken>
-              (nextAgentDir, std::make_shared<FinalSegmentCleanToken>());
+              (nextAgentDir, makeToken<FinalSegmentCleanToken>());
         } else {
           absorbedActiveToken = true;
         }
@@ -638,7 +638,7 @@ void LeaderElectionParticle::LeaderElectionAgent::activate() {
   } else if (agentState == State::SoleCandidate) {
     if (!testingBorder) {
       std::shared_ptr<BorderTestToken> token =
-          std::make_shared<BorderTestToken>(prevAgentDir, addNextBorder(0));
+          makeToken<BorderTestToken>(prevAgentDir, addNextBorder(0));
       passAgentToken(nextAgentDir, token);
       paintFrontSegment(-1);
       testingBorder = true;
@@ -753,13 +753,13 @@ generateSolitudeVectorTokens(std::pair<int, int> vector) {
   switch(vector.first) {
     case -1:
       candidateParticle->putToken
-          (std::make_shared<SolitudeNegativeXToken>(nextAgentDir, false));
+          (makeToken<SolitudeNegativeXToken>(nextAgentDir, false));
       break;
     case 0:
       break;
     case 1:
       candidateParticle->putToken
-          (std::make_shared<SolitudePositiveXToken>(nextAgentDir, false));
+          (makeToken<SolitudePositiveXToken>(nextAgentDir, false));
       break;
     default:
       Q_ASSERT(false);
@@ -768,13 +768,13 @@ generateSolitudeVectorTokens(std::pair<int, int> vector) {
   switch(vector.second) {
     case -1:
       candidateParticle->putToken
-          (std::make_shared<SolitudeNegativeYToken>(nextAgentDir, false));
+          (makeToken<SolitudeNegativeYToken>(nextAgentDir, false));
       break;
     case 0:
       break;
     case 1:
       candidateParticle->putToken
-          (std::make_shared<SolitudePositiveYToken>(nextAgentDir, false));
+          (makeToken<SolitudePositiveYToken>(nextAgentDir, false));
       break;
     default:
       Q_ASSERT(false);
@@ -1024,7 +1024,8 @@ void LeaderElectionParticle::LeaderElectionAgent::paintBackSegment(
 
 //----------------------------BEGIN SYSTEM CODE----------------------------
 
-LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb) {
+LeaderElectionSystem::LeaderElectionSystem(int numParticles, double holeProb)
+    : _stateTally(registerStateTally("State")) {
   Q_ASSERT(numParticles > 0);
   Q_ASSERT(0 <= holeProb && holeProb <= 1);
 
@@ -1081,13 +1082,6 @@ bool LeaderElectionSystem::hasTerminated() const {
     }
   #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<LeaderElectionParticle*>(p);
-    if (hp->state != LeaderElectionParticle::State::Leader &&
-        hp->state != LeaderElectionParticle::State::Finished) {
-      return false;
-    }
-  }
-
-  return true;
+  return _stateTally.allIn({LeaderElectionParticle::State::Leader,
+                            LeaderElectionParticle::State::Finished});
 }
@@ -367,7 +367,7 @@ class LeaderElectionParticle : public AmoebotParticle {
   };
 
   protected:
-   State state;
+   TrackedState<State> state;  // Tracked in the system's "State" tally.
    unsigned int currentAgent;
    std::vector<LeaderElectionAgent*> agents;
    std::array<int, 18> borderColorLabels;
@@ -383,8 +383,12 @@ class LeaderElectionSystem : public AmoebotSystem {
   LeaderElectionSystem(int numParticles = 100, double holeProb = 0.2);
 
   // Checks whether or not the system's run of the Leader Election algorithm has
-  // terminated (all particles in state Finished or Leader).
+  // terminated (all particles in state Finished or Leader). Apart from the
+  // debug-only connectivity check, runs in constant time using _stateTally.
   bool hasTerminated() const override;
+
+ private:
+  StateTally& _stateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_LEADERELECTION_H_
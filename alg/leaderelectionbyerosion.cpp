@@ -7,7 +7,7 @@
 LeaderElectionByErosionParticle::LeaderElectionByErosionParticle(
   const Node head, AmoebotSystem &system)
     : AmoebotParticle(head, -1, randDir(), system),
-      _state(State::Null) {}
+      _state(system.getStateTally("State"), State::Null) {}
 
 void LeaderElectionByErosionParticle::activate() {
   if (_state == State::Null) {  // "Setup" action.
@@ -85,57 +85,27 @@ bool LeaderElectionByErosionParticle::hasNbrInState(
 }
 
 bool LeaderElectionByErosionParticle::canErode() const {
-  // First, count the number of candidate neighbors.
-  uint numCandNbrs = 0;
-  for (int label : uniqueLabels()) {
-    if (hasNbrAtLabel(label) && nbrAtLabel(label)._state == State::Candidate)
-      ++numCandNbrs;
-  }
+  // First, collect and count the candidate neighbors. Note that it's okay in
+  // this particular case to work on the ring of 6 (distinct) labels since
+  // particles are instantiated as contracted and never move.
+  const unsigned int candNbrs =
+      nbrMaskWithProperty<LeaderElectionByErosionParticle>(
+          [](const LeaderElectionByErosionParticle& p) {
+            return p._state == State::Candidate;
+          });
+  const int numCandNbrs = maskSize(candNbrs);
 
   // Rule 1: Return true if there is exactly one candidate neighbor.
   if (numCandNbrs == 1)
     return true;
 
-  // Otherwise, determine if the candidate neighbors form a connected component.
-  if (numCandNbrs > 0) {
-    // Find any candidate neighbor.
-    int candLabel = labelOfFirstNbrInState({State::Candidate});
-    std::set<int> connectedCandLabels = {candLabel};
-
-    // Sweep counter-clockwise from this candidate, stopping when an unoccupied
-    // position or non-candidate neighbor is encountered. Note that it's okay in
-    // this particular case to hardcode the upper limit of 6 (distinct) labels
-    // since particles are instantiated as contracted and never move.
-    for (uint offset = 1; offset < 6; ++offset) {
-      int label = (candLabel + offset) % 6;
-      if (hasNbrAtLabel(label) && nbrAtLabel(label)._state == State::Candidate){
-        connectedCandLabels.insert(label);
-      } else {
-        break;
-      }
-    }
-
-    // Then do the same but in the clockwise direction.
-    for (uint offset = 1; offset < 6; ++offset) {
-      int label = (candLabel - offset + 6) % 6;
-      if (hasNbrAtLabel(label) && nbrAtLabel(label)._state == State::Candidate){
-        connectedCandLabels.insert(label);
-      } else {
-        break;
-      }
-    }
-
-    // Rule 2: Return true if there are 2 to 5 candidate neighbors that form a
-    // connected component.
-    return numCandNbrs >= 2 && numCandNbrs <= 5
-           && numCandNbrs == connectedCandLabels.size();
-  }
-
-  // Otherwise, this particle cannot erode.
-  return false;
+  // Rule 2: Return true if there are 2 to 5 candidate neighbors that form a
+  // connected component, i.e., a single run of consecutive labels.
+  return numCandNbrs >= 2 && numCandNbrs <= 5 && maskRuns(candNbrs, 6) == 1;
 }
 
-LeaderElectionByErosionSystem::LeaderElectionByErosionSystem(int numParticles) {
+LeaderElectionByErosionSystem::LeaderElectionByErosionSystem(int numParticles)
+    : _stateTally(registerStateTally("State")) {
   int x, y;
   for (int i = 1; i <= numParticles; ++i) {
     int layer = 1;
@@ -184,11 +154,9 @@ LeaderElectionByErosionSystem::LeaderElectionByErosionSystem(int numParticles) {
 }
 
 bool LeaderElectionByErosionSystem::hasTerminated() const {
-  for (auto p : particles) {
-    auto lep = dynamic_cast<LeaderElectionByErosionParticle*>(p);
-    if (lep->_state == LeaderElectionByErosionParticle::State::Leader)
-      return true;
-  }
+  return _stateTally.count(LeaderElectionByErosionParticle::State::Leader) > 0;
+}
 
-  return false;
+bool LeaderElectionByErosionSystem::supportsParallelActivations() const {
+  return true;
 }
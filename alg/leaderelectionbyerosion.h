@@ -63,8 +63,8 @@ class LeaderElectionByErosionParticle : public AmoebotParticle {
   bool canErode() const;
 
  protected:
-  // Particle memory.
-  State _state;
+  // Particle memory. _state is tracked in the system's "State" tally.
+  TrackedState<State> _state;
 
  private:
   friend class LeaderElectionByErosionSystem;
@@ -78,8 +78,15 @@ class LeaderElectionByErosionSystem : public AmoebotSystem {
   LeaderElectionByErosionSystem(int numParticles = 91);
 
   // Checks whether the system has completed leader election, i.e., there exists
-  // a particle in State::Leader.
+  // a particle in State::Leader. Runs in constant time using _stateTally.
   bool hasTerminated() const override;
+
+  // LeaderElectionByErosionParticles only inspect their neighbors, so this
+  // returns true.
+  bool supportsParallelActivations() const override;
+
+ private:
+  StateTally& _stateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_LEADERELECTIONBYEROSION_H_
@@ -12,7 +12,7 @@ ShapeFormationParticle::ShapeFormationParticle(const Node head,
                                                AmoebotSystem& system,
                                                State state, const QString mode)
   : AmoebotParticle(head, globalTailDir, orientation, system),
-    state(state),
+    state(system.getStateTally("State"), state),
     mode(mode),
     constructionDir(-1),
     moveDir(-1),
@@ -301,7 +301,8 @@ bool ShapeFormationParticle::hasTailFollower() const {
 }
 
 ShapeFormationSystem::ShapeFormationSystem(int numParticles, double holeProb,
-                                           QString mode) {
+                                           QString mode)
+    : _stateTally(registerStateTally("State")) {
   Q_ASSERT(mode == "h" || mode == "s" || mode == "t1" || mode == "t2" ||
            mode == "l");
   Q_ASSERT(numParticles > 0);
@@ -359,15 +360,8 @@ bool ShapeFormationSystem::hasTerminated() const {
     }
   #endif
 
-  for (auto p : particles) {
-    auto hp = dynamic_cast<ShapeFormationParticle*>(p);
-    if (hp->state != ShapeFormationParticle::State::Seed &&
-        hp->state != ShapeFormationParticle::State::Finish) {
-      return false;
-    }
-  }
-
-  return true;
+  return _stateTally.allIn({ShapeFormationParticle::State::Seed,
+                            ShapeFormationParticle::State::Finish});
 }
 
 std::set<QString> ShapeFormationSystem::getAcceptedModes() {
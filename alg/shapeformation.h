@@ -92,7 +92,7 @@ class ShapeFormationParticle : public AmoebotParticle {
   bool hasTailFollower() const;
 
  protected:
-  State state;
+  TrackedState<State> state;  // Tracked in the system's "State" tally.
   QString mode;
   int turnSignal;
   int constructionDir;
@@ -118,12 +118,16 @@ class ShapeFormationSystem : public AmoebotSystem  {
                        QString mode = "h");
 
   // Checks whether or not the system's run of the ShapeFormation formation
-  // algorithm has terminated (all particles in state Finish).
+  // algorithm has terminated (all particles in state Finish). Apart from the
+  // debug-only connectivity check, runs in constant time using _stateTally.
   bool hasTerminated() const override;
 
   // Returns a set of strings containing the current accepted modes of
   // Shapeformation.
   static std::set<QString> getAcceptedModes();
+
+ private:
+  StateTally& _stateTally;
 };
 
 #endif  // AMOEBOTSIM_ALG_SHAPEFORMATION_H_
@@ -0,0 +1,20 @@
+# Headless batch runner: runs independent replicas of an algorithm instance on
+# all cores without a GUI and writes their metrics, so that many runs can be
+# scripted on machines without a display. Only depends on QtCore.
+
+QT       = core
+CONFIG  += c++11 console
+CONFIG  -= app_bundle
+TARGET    = AmoebotSimBatch
+TEMPLATE  = app
+
+include(../AmoebotSimCore.pri)
+
+HEADERS += \
+    batchrunner.h \
+    replicarunner.h
+
+SOURCES += \
+    batchrunner.cpp \
+    main.cpp \
+    replicarunner.cpp
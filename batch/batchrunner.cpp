@@ -0,0 +1,111 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "batch/batchrunner.h"
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QtGlobal>
+
+#include "core/amoebotsystem.h"
+#include "core/metric.h"
+
+BatchRunner::BatchRunner(AlgorithmList& algorithms)
+    : _algorithms(algorithms) {}
+
+bool BatchRunner::setup(const QString signature, const QStringList parameters,
+                        const uint32_t seed,
+                        const RandomEngine::Kind engineKind,
+                        const Scheduler::Policy schedulerPolicy,
+                        const uint32_t schedulerSeed) {
+  Algorithm* alg = _algorithms.getAlgBySignature(signature);
+  if (alg == nullptr) {
+    _error = "unknown algorithm \"" + signature + "\"";
+    return false;
+  }
+
+  // Algorithms report the system they create (or why they refused to create
+  // one) through signals; capture both for the duration of instantiation.
+  _system.reset();
+  _error.clear();
+  auto systemConnection = QObject::connect(
+      alg, &Algorithm::setSystem,
+      [this](std::shared_ptr<System> system) { _system = system; });
+  auto logConnection = QObject::connect(
+      alg, &Algorithm::log,
+      [this](const QString msg, bool isError) {
+        if (isError) {
+          _error = msg;
+        }
+      });
+
+  AmoebotSystem::setNextSeed(seed);
+  AmoebotSystem::setNextEngineKind(engineKind);
+  const bool invoked = alg->instantiateFromStrings(parameters);
+
+  QObject::disconnect(systemConnection);
+  QObject::disconnect(logConnection);
+
+  if (!invoked || _system == nullptr) {
+    if (_error.isEmpty()) {
+      _error = "could not instantiate \"" + signature + "\"";
+    }
+    _system.reset();
+    return false;
+  }
+  _system->setScheduler(schedulerPolicy, schedulerSeed);
+
+  return true;
+}
+
+BatchRunner::Result BatchRunner::run(const StopConditions& conditions) {
+  Q_ASSERT(_system != nullptr);
+
+  // Reading the wall clock on every activation would dominate short
+  // activations, so the time limit is only checked every 1024 activations.
+  const unsigned long long timeCheckMask = 1023;
+  const Count& rounds = _system->getCount("# Rounds");
+  Result result;
+  result.activations = 0;
+
+  QElapsedTimer timer;
+  timer.start();
+  while (true) {
+    if (conditions.onTermination && _system->checkTermination()) {
+      result.stopReason = "termination";
+      break;
+    } else if (conditions.maxRounds > 0 &&
+               rounds._value >= conditions.maxRounds) {
+      result.stopReason = "rounds";
+      break;
+    } else if (conditions.maxActivations > 0 &&
+               result.activations >= conditions.maxActivations) {
+      result.stopReason = "activations";
+      break;
+    } else if (conditions.maxSeconds > 0 &&
+               (result.activations & timeCheckMask) == 0 &&
+               timer.elapsed() >= conditions.maxSeconds * 1000) {
+      result.stopReason = "time";
+      break;
+    }
+
+    _system->activate();
+    ++result.activations;
+  }
+
+  result.seconds = timer.elapsed() / 1000.0;
+  result.rounds = rounds._value;
+  result.terminated = (result.stopReason == "termination") ||
+                      _system->hasTerminated();
+
+  return result;
+}
+
+std::shared_ptr<System> BatchRunner::getSystem() const {
+  return _system;
+}
+
+QString BatchRunner::error() const {
+  return _error;
+}
@@ -0,0 +1,79 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the driver of the headless batch runner, which instantiates one
+// algorithm from the AlgorithmList and activates its particles until one of a
+// set of stop conditions holds. Unlike Simulator, it has no timer or GUI hooks
+// and only depends on QtCore.
+
+#ifndef AMOEBOTSIM_BATCH_BATCHRUNNER_H_
+#define AMOEBOTSIM_BATCH_BATCHRUNNER_H_
+
+#include <cstdint>
+#include <memory>
+
+#include <QString>
+#include <QStringList>
+
+#include "core/scheduler.h"
+#include "core/system.h"
+#include "helper/randomnumbergenerator.h"
+#include "ui/algorithm.h"
+
+class BatchRunner {
+ public:
+  // Conditions under which a run stops; a run stops as soon as any enabled
+  // condition holds. A value of 0 disables the respective limit. Termination is
+  // evaluated through System::checkTermination, so it respects the system's
+  // termination check interval.
+  struct StopConditions {
+    unsigned int maxRounds = 0;
+    unsigned long long maxActivations = 0;
+    double maxSeconds = 0;
+    bool onTermination = true;
+  };
+
+  // Summary of a completed run. stopReason names the condition that ended it:
+  // "termination", "rounds", "activations", or "time".
+  struct Result {
+    QString stopReason;
+    bool terminated;
+    unsigned int rounds;
+    unsigned long long activations;
+    double seconds;
+  };
+
+  // Constructs a runner using the algorithms of the given list.
+  explicit BatchRunner(AlgorithmList& algorithms);
+
+  // Instantiates the algorithm with the given signature from string-valued
+  // parameters (see Algorithm::instantiateFromStrings). The new system uses a
+  // random number engine of the given kind seeded with the given seed, and a
+  // scheduler of the given policy seeded with the given scheduler seed (see
+  // scheduler.h). Returns false if the algorithm does not exist or rejects the
+  // parameters; error() then describes the problem.
+  bool setup(const QString signature, const QStringList parameters,
+             const uint32_t seed,
+             const RandomEngine::Kind engineKind = RandomEngine::Kind::MT19937,
+             const Scheduler::Policy schedulerPolicy =
+                 Scheduler::Policy::Uniform,
+             const uint32_t schedulerSeed = 0);
+
+  // Activates particles of the instantiated system until one of the given stop
+  // conditions holds. Must only be called after a successful setup().
+  Result run(const StopConditions& conditions);
+
+  // Returns the instantiated system, or nullptr if setup() has not succeeded.
+  std::shared_ptr<System> getSystem() const;
+
+  // Returns a description of the last error encountered by setup().
+  QString error() const;
+
+ private:
+  AlgorithmList& _algorithms;
+  std::shared_ptr<System> _system;
+  QString _error;
+};
+
+#endif  // AMOEBOTSIM_BATCH_BATCHRUNNER_H_
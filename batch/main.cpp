@@ -0,0 +1,211 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Command line entry point of the headless batch runner. Example:
+//
+//   AmoebotSimBatch compression 100 4.0 --seed 7 --replicas 64 \
+//       --max-rounds 10000
+//
+// runs 64 replicas of Compression with 100 particles and lambda = 4.0, seeded
+// 7, 8, ..., 70, for 10000 rounds each on all available cores, and prints one
+// tab-separated row of final counts and measures per replica to stdout.
+
+#include <random>
+#include <vector>
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QTextStream>
+#include <QThread>
+
+#include "batch/batchrunner.h"
+#include "batch/replicarunner.h"
+#include "ui/algorithm.h"
+
+int main(int argc, char *argv[]) {
+  QCoreApplication app(argc, argv);
+  QCoreApplication::setApplicationName("AmoebotSimBatch");
+  QTextStream out(stdout);
+  QTextStream err(stderr);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Runs an AmoebotSim algorithm without a GUI. Parameters are given in the "
+      "order listed by --list; omitted trailing parameters take their "
+      "defaults.");
+  parser.addHelpOption();
+  parser.addPositionalArgument("algorithm", "Signature of the algorithm.");
+  parser.addPositionalArgument("parameters", "Algorithm parameters.",
+                               "[parameters...]");
+  QCommandLineOption listOption(
+      "list", "List the algorithm signatures and their parameters.");
+  QCommandLineOption seedOption(
+      "seed", "Seed of the first replica; replica i uses seed + i (default: "
+      "random).", "seed");
+  QCommandLineOption replicasOption(
+      "replicas", "Number of independent replicas to run (default: 1).",
+      "count");
+  QCommandLineOption threadsOption(
+      "threads", "Number of worker threads (default: # of cores).", "count");
+  QCommandLineOption engineOption(
+      "engine", "Random number engine: mt19937 (default) or xoshiro256**.",
+      "engine");
+  QCommandLineOption schedulerOption(
+      "scheduler", "Activation scheduler: uniform (default), permutation, "
+      "roundrobin, or adversarial.", "policy");
+  QCommandLineOption schedulerSeedOption(
+      "scheduler-seed", "Seed of the adversarial scheduler (default: each "
+      "replica's seed).", "seed");
+  QCommandLineOption roundsOption(
+      "max-rounds", "Stop after this many completed rounds.", "rounds");
+  QCommandLineOption activationsOption(
+      "max-activations", "Stop after this many activations.", "activations");
+  QCommandLineOption timeOption(
+      "max-seconds", "Stop after this much wall-clock time.", "seconds");
+  QCommandLineOption noTerminationOption(
+      "ignore-termination",
+      "Do not stop when the algorithm's termination condition holds.");
+  QCommandLineOption metricsOption(
+      "metrics", "Write the metrics JSON to this file (- for stdout). With "
+      "several replicas, each replica's seed is appended to the file name.",
+      "file");
+  parser.addOptions({listOption, seedOption, replicasOption, threadsOption,
+                     engineOption, schedulerOption, schedulerSeedOption,
+                     roundsOption, activationsOption, timeOption,
+                     noTerminationOption, metricsOption});
+  parser.process(app);
+
+  AlgorithmList algorithms;
+  if (parser.isSet(listOption)) {
+    for (auto alg : algorithms.getAlgs()) {
+      out << alg->getSignature() << " (" << alg->getName() << ")\n";
+      const QStringList names = alg->getParameterNames();
+      const QStringList defaults = alg->getParameterDefaults();
+      for (int i = 0; i < names.size(); ++i) {
+        out << "    " << names[i] << " [" << defaults[i] << "]\n";
+      }
+    }
+    return 0;
+  }
+
+  QStringList positional = parser.positionalArguments();
+  if (positional.isEmpty()) {
+    parser.showHelp(1);
+  }
+  const QString signature = positional.takeFirst();
+
+  // Parse the seeds, the number of threads, the engine, the scheduler, and the
+  // stop conditions.
+  bool ok = true;
+  uint32_t seed;
+  if (parser.isSet(seedOption)) {
+    seed = parser.value(seedOption).toUInt(&ok);
+  } else {
+    std::random_device device;
+    seed = device();
+  }
+  unsigned int numReplicas = 1;
+  if (ok && parser.isSet(replicasOption)) {
+    numReplicas = parser.value(replicasOption).toUInt(&ok);
+  }
+  int numThreads = QThread::idealThreadCount();
+  if (ok && parser.isSet(threadsOption)) {
+    numThreads = parser.value(threadsOption).toInt(&ok);
+  }
+  RandomEngine::Kind engineKind = RandomEngine::Kind::MT19937;
+  if (parser.isSet(engineOption)) {
+    const QString engine = parser.value(engineOption);
+    if (engine == RandomEngine::name(RandomEngine::Kind::Xoshiro256StarStar)) {
+      engineKind = RandomEngine::Kind::Xoshiro256StarStar;
+    } else if (engine != RandomEngine::name(RandomEngine::Kind::MT19937)) {
+      err << "unknown random number engine \"" << engine << "\"\n";
+      return 1;
+    }
+  }
+  Scheduler::Policy schedulerPolicy = Scheduler::Policy::Uniform;
+  if (parser.isSet(schedulerOption)) {
+    const QString policy = parser.value(schedulerOption);
+    bool found = false;
+    for (const Scheduler::Policy candidate : Scheduler::policies) {
+      if (policy == Scheduler::name(candidate)) {
+        schedulerPolicy = candidate;
+        found = true;
+      }
+    }
+    if (!found) {
+      err << "unknown scheduler \"" << policy << "\"\n";
+      return 1;
+    }
+  }
+  uint32_t schedulerSeed = 0;
+  if (ok && parser.isSet(schedulerSeedOption)) {
+    schedulerSeed = parser.value(schedulerSeedOption).toUInt(&ok);
+  }
+  BatchRunner::StopConditions conditions;
+  if (ok && parser.isSet(roundsOption)) {
+    conditions.maxRounds = parser.value(roundsOption).toUInt(&ok);
+  }
+  if (ok && parser.isSet(activationsOption)) {
+    conditions.maxActivations = parser.value(activationsOption).toULongLong(&ok);
+  }
+  if (ok && parser.isSet(timeOption)) {
+    conditions.maxSeconds = parser.value(timeOption).toDouble(&ok);
+  }
+  conditions.onTermination = !parser.isSet(noTerminationOption);
+  if (!ok || numReplicas == 0 || numThreads <= 0) {
+    err << "invalid numeric option value\n";
+    return 1;
+  } else if (numReplicas > 1 && parser.value(metricsOption) == "-") {
+    err << "--metrics - requires a single replica\n";
+    return 1;
+  } else if (!conditions.onTermination && conditions.maxRounds == 0 &&
+             conditions.maxActivations == 0 && conditions.maxSeconds <= 0) {
+    err << "--ignore-termination requires another stop condition\n";
+    return 1;
+  }
+
+  std::vector<uint32_t> seeds;
+  for (unsigned int i = 0; i < numReplicas; ++i) {
+    seeds.push_back(seed + i);
+  }
+  ReplicaRunner runner(signature, positional, conditions, engineKind,
+                       schedulerPolicy, parser.isSet(schedulerSeedOption),
+                       schedulerSeed);
+  const std::vector<ReplicaRunner::Replica> replicas =
+      runner.run(seeds, numThreads, parser.isSet(metricsOption));
+
+  // All replicas share their parameters, so if one could not be instantiated,
+  // none could; report the error once.
+  if (!replicas.front().ok) {
+    err << replicas.front().error << "\n";
+    return 1;
+  }
+
+  // Write the metrics, and print the table wherever the metrics do not go.
+  for (const auto& replica : replicas) {
+    if (parser.value(metricsOption) == "-") {
+      out << replica.metricsJSON << "\n";
+    } else if (parser.isSet(metricsOption)) {
+      QString fileName = parser.value(metricsOption);
+      if (numReplicas > 1) {
+        const int ext = fileName.lastIndexOf('.');
+        const QString suffix = "_" + QString::number(replica.seed);
+        fileName = (ext > 0) ? fileName.insert(ext, suffix) : fileName + suffix;
+      }
+      QFile metricsFile(fileName);
+      if (!metricsFile.open(QIODevice::WriteOnly | QIODevice::Text)) {
+        err << "could not open " << fileName << "\n";
+        return 1;
+      }
+      QTextStream metricsStream(&metricsFile);
+      metricsStream << replica.metricsJSON;
+    }
+  }
+
+  QTextStream& table = (parser.value(metricsOption) == "-") ? err : out;
+  table << ReplicaRunner::formatTable(replicas);
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "batch/replicarunner.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+#include "core/metric.h"
+#include "ui/algorithm.h"
+
+ReplicaRunner::ReplicaRunner(const QString signature,
+                             const QStringList parameters,
+                             const BatchRunner::StopConditions conditions,
+                             const RandomEngine::Kind engineKind,
+                             const Scheduler::Policy schedulerPolicy,
+                             const bool fixSchedulerSeed,
+                             const uint32_t schedulerSeed)
+    : _signature(signature),
+      _parameters(parameters),
+      _conditions(conditions),
+      _engineKind(engineKind),
+      _schedulerPolicy(schedulerPolicy),
+      _fixSchedulerSeed(fixSchedulerSeed),
+      _schedulerSeed(schedulerSeed) {}
+
+std::vector<ReplicaRunner::Replica> ReplicaRunner::run(
+    const std::vector<uint32_t>& seeds, int numThreads,
+    bool keepMetricsJSON) const {
+  std::vector<Replica> replicas(seeds.size());
+  std::atomic<unsigned int> nextReplica(0);
+
+  // Each worker repeatedly claims the next unstarted replica. Algorithms report
+  // the systems they create through signals, so every worker needs its own
+  // AlgorithmList to avoid receiving other workers' systems.
+  auto worker = [&]() {
+    AlgorithmList algorithms;
+    BatchRunner runner(algorithms);
+    for (unsigned int i = nextReplica++; i < seeds.size(); i = nextReplica++) {
+      replicas[i] = runReplica(runner, seeds[i], keepMetricsJSON);
+    }
+  };
+
+  numThreads = std::max(1, std::min(numThreads, static_cast<int>(seeds.size())));
+  std::vector<std::thread> threads;
+  for (int i = 1; i < numThreads; ++i) {
+    threads.emplace_back(worker);
+  }
+  worker();
+  for (auto& thread : threads) {
+    thread.join();
+  }
+
+  return replicas;
+}
+
+QString ReplicaRunner::formatTable(const std::vector<Replica>& replicas) {
+  QString table = "seed\tstop\tterminated\trounds\tactivations\tseconds";
+  auto header = std::find_if(replicas.begin(), replicas.end(),
+                             [](const Replica& r) { return r.ok; });
+  if (header != replicas.end()) {
+    for (const auto& metric : header->metrics) {
+      table += "\t" + metric.first;
+    }
+  }
+  table += "\n";
+
+  for (const auto& replica : replicas) {
+    table += QString::number(replica.seed);
+    if (!replica.ok) {
+      table += "\terror: " + replica.error + "\n";
+      continue;
+    }
+    table += "\t" + replica.result.stopReason;
+    table += "\t" + QString::number(replica.result.terminated ? 1 : 0);
+    table += "\t" + QString::number(replica.result.rounds);
+    table += "\t" + QString::number(replica.result.activations);
+    table += "\t" + QString::number(replica.result.seconds);
+    for (const auto& metric : replica.metrics) {
+      table += "\t" + QString::number(metric.second);
+    }
+    table += "\n";
+  }
+
+  return table;
+}
+
+ReplicaRunner::Replica ReplicaRunner::runReplica(BatchRunner& runner,
+                                                 const uint32_t seed,
+                                                 bool keepMetricsJSON) const {
+  Replica replica;
+  replica.seed = seed;
+  replica.ok = runner.setup(_signature, _parameters, seed, _engineKind,
+                            _schedulerPolicy,
+                            _fixSchedulerSeed ? _schedulerSeed : seed);
+  if (!replica.ok) {
+    replica.error = runner.error();
+    return replica;
+  }
+
+  replica.result = runner.run(_conditions);
+  const auto system = runner.getSystem();
+  for (const auto c : system->getCounts()) {
+    replica.metrics.push_back(std::make_pair(c->_name, c->_value));
+  }
+  for (const auto m : system->getMeasures()) {
+    replica.metrics.push_back(std::make_pair(m->_name, m->calculate()));
+  }
+  if (keepMetricsJSON) {
+    replica.metricsJSON = system->metricsAsJSON();
+  }
+
+  return replica;
+}
@@ -0,0 +1,78 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a runner for independent replicas of one algorithm instance that
+// differ only in their seeds. Replicas are distributed over a pool of worker
+// threads; each worker instantiates its systems through its own AlgorithmList
+// and BatchRunner, so replicas share no state. The final counts and measures of
+// every replica are gathered into one table.
+
+#ifndef AMOEBOTSIM_BATCH_REPLICARUNNER_H_
+#define AMOEBOTSIM_BATCH_REPLICARUNNER_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include <QString>
+#include <QStringList>
+
+#include "batch/batchrunner.h"
+
+class ReplicaRunner {
+ public:
+  // The outcome of one replica. If the replica could not be instantiated, ok is
+  // false and error describes why. metrics lists the final value of every count
+  // followed by the value of every measure evaluated on the final system, in
+  // registration order. metricsJSON holds the system's full metrics JSON if it
+  // was requested.
+  struct Replica {
+    uint32_t seed;
+    bool ok;
+    QString error;
+    BatchRunner::Result result;
+    std::vector<std::pair<QString, double>> metrics;
+    QString metricsJSON;
+  };
+
+  // Constructs a runner for replicas of the algorithm with the given signature
+  // and string-valued parameters, each using a random number engine of the
+  // given kind and a scheduler of the given policy and run until the given stop
+  // conditions. The scheduler of each replica is seeded with the given
+  // scheduler seed if fixSchedulerSeed is true, and with the replica's seed
+  // otherwise.
+  ReplicaRunner(const QString signature, const QStringList parameters,
+                const BatchRunner::StopConditions conditions,
+                const RandomEngine::Kind engineKind,
+                const Scheduler::Policy schedulerPolicy =
+                    Scheduler::Policy::Uniform,
+                const bool fixSchedulerSeed = false,
+                const uint32_t schedulerSeed = 0);
+
+  // Runs one replica per given seed on numThreads worker threads and returns
+  // the replicas in the order of the seeds. If keepMetricsJSON is true, each
+  // replica's metrics JSON is kept as well.
+  std::vector<Replica> run(const std::vector<uint32_t>& seeds, int numThreads,
+                           bool keepMetricsJSON = false) const;
+
+  // Formats the given replicas as a tab-separated table with a header row and
+  // one row per replica. Metric columns are taken from the first successful
+  // replica, since all replicas of an algorithm register the same metrics.
+  static QString formatTable(const std::vector<Replica>& replicas);
+
+ private:
+  // Instantiates and runs a single replica using the given runner.
+  Replica runReplica(BatchRunner& runner, const uint32_t seed,
+                     bool keepMetricsJSON) const;
+
+  const QString _signature;
+  const QStringList _parameters;
+  const BatchRunner::StopConditions _conditions;
+  const RandomEngine::Kind _engineKind;
+  const Scheduler::Policy _schedulerPolicy;
+  const bool _fixSchedulerSeed;
+  const uint32_t _schedulerSeed;
+};
+
+#endif  // AMOEBOTSIM_BATCH_REPLICARUNNER_H_
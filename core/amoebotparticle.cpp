@@ -4,13 +4,52 @@
 
 #include "core/amoebotparticle.h"
 
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <typeindex>
+
 AmoebotParticle::AmoebotParticle(const Node& head, int globalTailDir,
                                  const int orientation, AmoebotSystem& system)
   : LocalParticle(head, globalTailDir, orientation),
-    system(system) {}
+    system(system),
+    tokenStamp(0),
+    nbrCacheValid(false),
+    systemIndex(-1),
+    activationEpoch(0),
+    moveRequest(MoveRequest::None),
+    moveRequestLabel(-1) {}
+
+AmoebotParticle::AmoebotParticle(const AmoebotParticle& other)
+  : LocalParticle(other),
+    RandomNumberGenerator(other),
+    system(other.system),
+    tokenBuckets(other.tokenBuckets),
+    tokenStamp(other.tokenStamp),
+    nbrCacheValid(false),
+    systemIndex(other.systemIndex),
+    activationEpoch(other.activationEpoch),
+    moveRequest(other.moveRequest),
+    moveRequestLabel(other.moveRequestLabel) {}
 
 AmoebotParticle::~AmoebotParticle() {}
 
+void* AmoebotParticle::operator new(std::size_t size) {
+  return ParticlePool::allocate(size);
+}
+
+void AmoebotParticle::operator delete(void* ptr) {
+  ParticlePool::deallocate(ptr);
+}
+
+void AmoebotParticle::computeNextState() {
+  Q_ASSERT(false);  // This particle does not support synchronous rounds.
+}
+
+void AmoebotParticle::commitNextState(bool moved) {
+  Q_UNUSED(moved);
+}
+
 int AmoebotParticle::headMarkGlobalDir() const {
   const int dir = headMarkDir();
   Q_ASSERT(-1 <= dir && dir < 6);
@@ -45,11 +84,32 @@ void AmoebotParticle::expand(int label) {
   const int globalExpansionDir = localToGlobalDir(label);
   head = head.nodeInDir(globalExpansionDir);
   globalTailDir = (globalExpansionDir + 3) % 6;
-  system.particleMap[head] = this;
+  system.setOccupant(head, this);
+  system.refreshNbrCache(*this);
 
   system.registerMovement();
 }
 
+void AmoebotParticle::requestExpand(int label) {
+  Q_ASSERT(0 <= label && label < 6);
+  Q_ASSERT(isContracted() && moveRequest == MoveRequest::None);
+
+  moveRequest = MoveRequest::Expand;
+  moveRequestLabel = label;
+}
+
+void AmoebotParticle::requestContractHead() {
+  Q_ASSERT(isExpanded() && moveRequest == MoveRequest::None);
+
+  moveRequest = MoveRequest::ContractHead;
+}
+
+void AmoebotParticle::requestContractTail() {
+  Q_ASSERT(isExpanded() && moveRequest == MoveRequest::None);
+
+  moveRequest = MoveRequest::ContractTail;
+}
+
 bool AmoebotParticle::canPush(int label) const {
   Q_ASSERT(0 <= label && label < 6);
 
@@ -66,12 +126,14 @@ void AmoebotParticle::push(int label) {
 
   head = handoverNode;
   globalTailDir = (globalExpansionDir + 3) % 6;
-  system.particleMap[handoverNode] = this;
+  system.setOccupant(handoverNode, this);
 
   if (handoverNode == neighbor.head) {
     neighbor.head = neighbor.tail();
   }
   neighbor.globalTailDir = -1;
+  system.refreshNbrCache(*this);
+  system.refreshNbrCache(neighbor);
 
   system.registerMovement(2);
   system.registerActivation(&neighbor);
@@ -87,9 +149,10 @@ void AmoebotParticle::contract(int label) {
 void AmoebotParticle::contractHead() {
   Q_ASSERT(isExpanded());
 
-  system.particleMap.erase(head);
+  system.clearOccupant(head);
   head = tail();
   globalTailDir = -1;
+  system.refreshNbrCache(*this);
 
   system.registerMovement();
 }
@@ -97,8 +160,9 @@ void AmoebotParticle::contractHead() {
 void AmoebotParticle::contractTail() {
   Q_ASSERT(isExpanded());
 
-  system.particleMap.erase(tail());
+  system.clearOccupant(tail());
   globalTailDir = -1;
+  system.refreshNbrCache(*this);
 
   system.registerMovement();
 }
@@ -124,15 +188,16 @@ void AmoebotParticle::pull(int label) {
   globalTailDir = -1;
   neighbor.head = handoverNode;
   neighbor.globalTailDir = globalPullDir;
-  system.particleMap[handoverNode] = &neighbor;
+  system.setOccupant(handoverNode, &neighbor);
+  system.refreshNbrCache(*this);
+  system.refreshNbrCache(neighbor);
 
   system.registerMovement(2);
   system.registerActivation(&neighbor);
 }
 
 bool AmoebotParticle::hasNbrAtLabel(int label) const {
-  const Node neighboringNode = nbrNodeReachedViaLabel(label);
-  return system.particleMap.find(neighboringNode) != system.particleMap.end();
+  return nbrPtrAtLabel(label) != nullptr;
 }
 
 bool AmoebotParticle::hasHeadAtLabel(int label) {
@@ -155,25 +220,186 @@ bool AmoebotParticle::hasTailAtLabel(int label) {
 
 bool AmoebotParticle::hasObjectAtLabel(int label) const {
   const Node neighboringNode = nbrNodeReachedViaLabel(label);
-  return system.objectMap.find(neighboringNode) != system.objectMap.end();
+  return system.occupancy.objectAt(neighboringNode) != nullptr;
 }
 
 bool AmoebotParticle::hasObjectNbr() const {
-  return labelOfFirstObjectNbr() != -1;
+  return objectMask() != 0;
 }
 
 int AmoebotParticle::labelOfFirstObjectNbr(int startLabel) const {
-  const int labelLimit = isContracted() ? 6 : 10;
-  for (int labelOffset = 0; labelOffset < labelLimit; labelOffset++) {
-    const int label = (startLabel + labelOffset) % labelLimit;
-    if (hasObjectAtLabel(label)) {
-      return label;
+  return firstLabelInMask(objectMask(), startLabel, numLabels());
+}
+
+unsigned int AmoebotParticle::nbrMask() const {
+  return labelMask([this](int label) { return hasNbrAtLabel(label); });
+}
+
+unsigned int AmoebotParticle::objectMask() const {
+  return labelMask([this](int label) { return hasObjectAtLabel(label); });
+}
+
+void AmoebotParticle::putToken(std::shared_ptr<Token> token) {
+  Q_ASSERT(token != nullptr);
+
+  const TokenTypeInfo& type = tokenTypeOf(*token);
+  if (static_cast<int>(tokenBuckets.size()) < type.span) {
+    tokenBuckets.resize(type.span, TokenBucket{nullptr, 0, 0, {}});
+  }
+  for (int index : type.countedAs) {
+    tokenBuckets[index].count++;
+  }
+
+  TokenBucket& bucket = tokenBuckets[type.index];
+  bucket.type = &type;
+  bucket.entries.push_back({tokenStamp++, std::move(token)});
+}
+
+void AmoebotParticle::removeToken(const TokenLocation& location) {
+  TokenBucket& bucket = tokenBuckets[location.bucket];
+  for (int index : bucket.type->countedAs) {
+    tokenBuckets[index].count--;
+  }
+
+  // takeToken has always removed a token by moving the first token of the
+  // collection into its place, which algorithms may depend on. Mirror this by
+  // giving the first token the removed token's stamp.
+  const int front = frontTokenBucket();
+  const std::uint64_t stamp = bucket.entries[location.entry].stamp;
+  if (front == location.bucket) {
+    if (location.entry != bucket.head) {
+      bucket.entries[location.entry].token =
+          std::move(bucket.entries[bucket.head].token);
+    }
+    popTokenBucket(bucket);
+  } else {
+    if (location.entry == bucket.head) {
+      popTokenBucket(bucket);
+    } else {
+      bucket.entries.erase(bucket.entries.begin() + location.entry);
     }
+
+    TokenBucket& frontBucket = tokenBuckets[front];
+    std::shared_ptr<Token> token =
+        std::move(frontBucket.entries[frontBucket.head].token);
+    popTokenBucket(frontBucket);
+    auto it = std::upper_bound(
+        frontBucket.entries.begin() + frontBucket.head,
+        frontBucket.entries.end(), stamp,
+        [](std::uint64_t stamp, const TokenEntry& entry) {
+          return stamp < entry.stamp;
+        });
+    frontBucket.entries.insert(it, {stamp, std::move(token)});
   }
+}
 
-  return -1;
+int AmoebotParticle::frontTokenBucket() const {
+  int front = -1;
+  for (std::size_t b = 0; b < tokenBuckets.size(); ++b) {
+    const TokenBucket& bucket = tokenBuckets[b];
+    if (bucket.head == bucket.entries.size()) {
+      continue;
+    } else if (front == -1 ||
+               bucket.entries[bucket.head].stamp <
+               tokenBuckets[front].entries[tokenBuckets[front].head].stamp) {
+      front = static_cast<int>(b);
+    }
+  }
+  return front;
 }
 
-void AmoebotParticle::putToken(std::shared_ptr<Token> token) {
-  tokens.push_back(token);
+void AmoebotParticle::popTokenBucket(TokenBucket& bucket) {
+  bucket.entries[bucket.head++].token.reset();
+
+  // Popping only advances head; drop the consumed entries once the bucket is
+  // empty or they make up most of it.
+  if (bucket.head == bucket.entries.size()) {
+    bucket.entries.clear();
+    bucket.head = 0;
+  } else if (bucket.head >= 16 && 2 * bucket.head >= bucket.entries.size()) {
+    bucket.entries.erase(bucket.entries.begin(),
+                         bucket.entries.begin() + bucket.head);
+    bucket.head = 0;
+  }
+}
+
+struct AmoebotParticle::TokenTypeRegistry {
+  std::mutex mutex;
+  std::deque<TokenTypeInfo> types;
+  std::map<std::type_index, TokenTypeInfo*> byType;
+};
+
+AmoebotParticle::TokenTypeInfo::TokenTypeInfo(
+    int index, const std::type_info& type, bool (*isInstance)(const Token&))
+  : index(index),
+    type(type),
+    isInstance(isInstance),
+    resolved(false),
+    span(0) {}
+
+bool AmoebotParticle::TokenTypeInfo::countsAs(int index) const {
+  for (int other : countedAs) {
+    if (other == index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+AmoebotParticle::TokenTypeRegistry& AmoebotParticle::tokenTypeRegistry() {
+  static TokenTypeRegistry registry;
+  return registry;
+}
+
+const AmoebotParticle::TokenTypeInfo* AmoebotParticle::registerTokenType(
+    const std::type_info& type, bool (*isInstance)(const Token&)) {
+  TokenTypeRegistry& registry = tokenTypeRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  auto it = registry.byType.find(std::type_index(type));
+  if (it != registry.byType.end()) {
+    // Only possible if the type was first seen as a token's dynamic type,
+    // i.e., if it is queried for before static initialization is complete.
+    it->second->isInstance = isInstance;
+    return it->second;
+  }
+
+  registry.types.emplace_back(registry.types.size(), type, isInstance);
+  registry.byType[std::type_index(type)] = &registry.types.back();
+  return &registry.types.back();
+}
+
+const AmoebotParticle::TokenTypeInfo& AmoebotParticle::tokenTypeOf(
+    Token& token) {
+  const TokenTypeInfo* info = token.typeInfo;
+  if (info != nullptr && info->resolved.load(std::memory_order_acquire)) {
+    return *info;
+  }
+
+  TokenTypeRegistry& registry = tokenTypeRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (info == nullptr) {
+    const std::type_info& type = typeid(token);
+    auto it = registry.byType.find(std::type_index(type));
+    if (it == registry.byType.end()) {
+      registry.types.emplace_back(registry.types.size(), type, nullptr);
+      it = registry.byType.emplace(std::type_index(type),
+                                   &registry.types.back()).first;
+    }
+    info = it->second;
+    token.typeInfo = info;
+  }
+
+  TokenTypeInfo& resolving = *registry.byType[std::type_index(info->type)];
+  if (!resolving.resolved.load(std::memory_order_relaxed)) {
+    for (const TokenTypeInfo& other : registry.types) {
+      if (&other == &resolving ||
+          (other.isInstance != nullptr && other.isInstance(token))) {
+        resolving.countedAs.push_back(other.index);
+        resolving.span = std::max(resolving.span, other.index + 1);
+      }
+    }
+    resolving.resolved.store(true, std::memory_order_release);
+  }
+
+  return resolving;
 }
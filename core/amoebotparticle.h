@@ -13,17 +13,28 @@
 #ifndef AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
 #define AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
 
-#include <deque>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <map>
 #include <memory>
+#include <typeinfo>
+#include <utility>
+#include <vector>
 
 #include "core/amoebotsystem.h"
 #include "core/localparticle.h"
 #include "core/node.h"
+#include "core/tokenpool.h"
 #include "helper/randomnumbergenerator.h"
 
 class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
+  friend class AmoebotSystem;
+
+  // Describes a token type known to the token collections (see below).
+  struct TokenTypeInfo;
+
  public:
   // Constructs a new particle with a node position for its head, a global
   // compass direction from its head to its tail (-1 if contracted), an offset
@@ -31,14 +42,39 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   AmoebotParticle(const Node& head, int globalTailDir, const int orientation,
                   AmoebotSystem& system);
 
+  // Copies a particle. The copy is not part of any system's bookkeeping, so it
+  // does not share the original's neighbor cache and instead looks up its
+  // neighbors in the system's occupancy index; copies are only meant as
+  // snapshots of a particle's state.
+  AmoebotParticle(const AmoebotParticle& other);
+
   // Deletes the tokens this particle holds before destructing the particle.
   // These deletions are handled by the shared_ptrs.
   virtual ~AmoebotParticle();
 
+  // Particles are allocated from the particle pool of the system being
+  // constructed or activated on the calling thread (see ParticlePool).
+  static void* operator new(std::size_t size);
+  static void operator delete(void* ptr);
+
   // Executes one particle activation. The '= 0' indicates that this is a pure
   // virtual function which must be overridden by any particle subclasses.
   virtual void activate() = 0;
 
+  // Functions for synchronous rounds (see
+  // AmoebotSystem::activateSynchronousRound), which particle subclasses opt
+  // into by overriding both. computeNextState is the read phase of an
+  // activation. It runs concurrently with the other particles' read phases, so
+  // it may only read the current state of this particle and its neighbors,
+  // write this particle's next state, and request at most one movement; it
+  // must not change anything shared, such as its neighbors, its or their
+  // tokens, or the system's counts. commitNextState is the write phase, which
+  // runs after the round's movements were carried out. It makes the next state
+  // current and is told whether the requested movement was carried out (false
+  // if none was requested or it lost a conflict).
+  virtual void computeNextState();
+  virtual void commitNextState(bool moved);
+
   // Returns the global direction from the head (respectively, tail) on which to
   // draw the direction markers (-1 indicates no marker). Meant to provide info
   // to the visualization and should not be called by any particle algorithms.
@@ -58,6 +94,13 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   bool canExpand(int label) const;
   void expand(int label);
 
+  // Functions for requesting a movement during computeNextState instead of
+  // performing it. The movement is carried out between the read and write
+  // phases of the synchronous round if it is still valid then.
+  void requestExpand(int label);
+  void requestContractHead();
+  void requestContractTail();
+
   // Functions for handover expansion. canPush checks if this particle is
   // contracted and the position in the direction of the specified port is
   // occupied by a neighboring expanded particle. push performs the handover.
@@ -107,15 +150,46 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
       std::function<bool(const ParticleType&)> propertyCheck,
       int startLabel = 0) const;
 
+  // Returns the label mask (see LocalParticle::labelMask) of the ports incident
+  // to neighboring particles, neighboring objects, and neighboring particles
+  // satisfying the specified property, respectively. Each reads the cached
+  // neighborhood once, so repeated queries about the same neighborhood (e.g.,
+  // counting or connectivity checks) should work on the mask instead.
+  unsigned int nbrMask() const;
+  unsigned int objectMask() const;
+  template<class ParticleType>
+  unsigned int nbrMaskWithProperty(
+      std::function<bool(const ParticleType&)> propertyCheck) const;
+
   /* TOKEN IMPLEMENTATION & FUNCTIONS */
 
   // A struct expressing the most basic version of a token. Particle subclasses
   // using tokens should write their token structs to inherit from this one.
-  struct Token { virtual ~Token(){ } };
+  struct Token {
+    Token() = default;
+    Token(const Token&) {}
+    Token& operator=(const Token&) { return *this; }
+    virtual ~Token(){ }
+
+   private:
+    friend class AmoebotParticle;
+
+    // The type of this token as a whole, set by makeToken or on the token's
+    // first putToken. Copies look their own type up again, since a copy may be
+    // sliced to a base type.
+    const TokenTypeInfo* typeInfo = nullptr;
+  };
+
+  // Creates a token of the specified type from the given constructor
+  // arguments. Unlike std::make_shared, the token and its reference count are
+  // allocated from a pool that recycles the memory of destroyed tokens (see
+  // TokenPool), so creating and discarding tokens rarely touches the heap.
+  template<class TokenType, class... Args>
+  static std::shared_ptr<TokenType> makeToken(Args&&... args);
 
   // Functions for handling tokens. putToken adds the given token reference to
   // this particle's collection. peekAtToken returns a reference to the first
-  // token in this particle's collection which is of the specified type.
+  // token put into this particle's collection which is of the specified type.
   // takeToken does the same thing as peekAtToken, but additionally removes the
   // returned reference from this particle's collection. Note that peekAtToken
   // and takeToken both fail when no token of the given type exists in the
@@ -129,7 +203,7 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   // Functions for basic token-related information. countTokens returns the
   // number of tokens of the specified type in this particle's collection.
   // hasToken checks whether this particle has at least one token of the given
-  // type (equivalent to countTokens > 0).
+  // type (equivalent to countTokens > 0). Both take constant time.
   template<class TokenType>
   int countTokens() const;
   template<class TokenType>
@@ -155,17 +229,142 @@ class AmoebotParticle : public LocalParticle, public RandomNumberGenerator {
   AmoebotSystem& system;
 
  private:
-  std::deque<std::shared_ptr<Token>> tokens;
+  // Every token type is assigned a small index when it is registered. A type
+  // named in any token function (e.g., hasToken<DemoToken>) is registered
+  // during static initialization through RegisteredTokenType, so all queryable
+  // types are known before the first token is put; a type that only ever
+  // appears as the dynamic type of a token is registered on its first put.
+  // When a token of some dynamic type is put for the first time, the registry
+  // records which registered types it counts as: its own and any registered
+  // base types, found by one dynamic_cast each.
+  struct TokenTypeInfo {
+    TokenTypeInfo(int index, const std::type_info& type,
+                  bool (*isInstance)(const Token&));
+
+    // Returns whether tokens of this type count as tokens of the type with the
+    // given index.
+    bool countsAs(int index) const;
+
+    const int index;
+    const std::type_info& type;
+    bool (*isInstance)(const Token&);  // nullptr if never queried.
+    std::atomic<bool> resolved;  // Whether countedAs has been filled in.
+    std::vector<int> countedAs;
+    int span;  // One more than the largest index in countedAs.
+  };
+
+  template<class TokenType>
+  struct RegisteredTokenType {
+    static const TokenTypeInfo* const info;
+    static bool isInstance(const Token& token) {
+      return dynamic_cast<const TokenType*>(&token) != nullptr;
+    }
+  };
+
+  // The registry of token types, shared by all particles (see the .cpp file).
+  struct TokenTypeRegistry;
+  static TokenTypeRegistry& tokenTypeRegistry();
+
+  // Registers a token type that can be queried for, returning its description.
+  static const TokenTypeInfo* registerTokenType(
+      const std::type_info& type, bool (*isInstance)(const Token&));
+
+  // Returns the description of the given token's dynamic type, registering the
+  // type and resolving the types it counts as if necessary.
+  static const TokenTypeInfo& tokenTypeOf(Token& token);
+
+  // The token collection has one bucket per registered token type, indexed by
+  // the type's index and only allocated up to the largest index this particle
+  // has needed. A bucket's entries are the tokens whose dynamic type is exactly
+  // the bucket's type, and its count is the number of held tokens that count
+  // as its type, so hasToken and countTokens are a single lookup. Tokens are
+  // stamped with increasing per-particle sequence numbers that give their
+  // position in the collection; peekAtToken and takeToken return the matching
+  // token with the smallest stamp, and each bucket is kept sorted by stamp.
+  struct TokenEntry {
+    std::uint64_t stamp;
+    std::shared_ptr<Token> token;
+  };
+  struct TokenBucket {
+    const TokenTypeInfo* type;  // nullptr until a token of this type is put.
+    int count;
+    std::size_t head;
+    std::vector<TokenEntry> entries;
+  };
+  struct TokenLocation {
+    int bucket;
+    std::size_t entry;
+  };
+
+  // Locates the first token in this particle's collection which is of the
+  // specified type and satisfies the given property (if not nullptr). Returns a
+  // location with bucket -1 if there is no such token.
+  template<class TokenType>
+  TokenLocation locateToken(
+      const std::function<bool(const std::shared_ptr<TokenType>)>*
+      propertyCheck) const;
+
+  // Removes the token at the given location from this particle's collection.
+  void removeToken(const TokenLocation& location);
+
+  // Returns the index of the bucket holding the first token in this particle's
+  // collection, or -1 if the collection is empty.
+  int frontTokenBucket() const;
+
+  // Drops the first entry of the given bucket.
+  static void popTokenBucket(TokenBucket& bucket);
+
+  std::vector<TokenBucket> tokenBuckets;
+  std::uint64_t tokenStamp;
+
+  // Returns the particle occupying the node reached via the given label, or
+  // nullptr if there is none. Reads the neighbor cache if it is valid.
+  AmoebotParticle* nbrPtrAtLabel(int label) const;
+
+  // The particles occupying the six nodes adjacent to this particle's head
+  // (nbrCache[0]) and, if it is expanded, its tail (nbrCache[1]), indexed by
+  // global direction; nullptr marks an unoccupied node. An expanded particle
+  // sees itself in the slots between its head and tail, just like a lookup in
+  // the occupancy index would. AmoebotSystem fills the cache on insertion and
+  // updates it whenever an adjacent node's occupant changes (see
+  // AmoebotSystem::setOccupant), so neighbor queries are array loads.
+  AmoebotParticle* nbrCache[2][6];
+  bool nbrCacheValid;
+
+  // Position of this particle in its system's particle list (-1 if it has not
+  // been inserted), maintained by AmoebotSystem so removal needs no search.
+  int systemIndex;
+
+  // The system's round epoch at this particle's last activation (0 if it has
+  // never been activated); see AmoebotSystem::registerActivation.
+  unsigned int activationEpoch;
+
+  // The movement requested during the current synchronous round, if any.
+  enum class MoveRequest { None, Expand, ContractHead, ContractTail };
+  MoveRequest moveRequest;
+  int moveRequestLabel;
 };
 
+inline AmoebotParticle* AmoebotParticle::nbrPtrAtLabel(int label) const {
+  if (!nbrCacheValid) {
+    return system.occupancy.particleAt(nbrNodeReachedViaLabel(label));
+  } else if (isContracted()) {
+    Q_ASSERT(0 <= label && label < 6);
+    return nbrCache[0][(orientation + label) % 6];
+  } else {
+    Q_ASSERT(0 <= label && label < 10);
+    return nbrCache[isHeadLabel(label) ? 0 : 1][labelToGlobalDir(label)];
+  }
+}
+
 template<class ParticleType>
 ParticleType& AmoebotParticle::nbrAtLabel(int label) const {
-  Node nbrNode = nbrNodeReachedViaLabel(label);
-  auto it = system.particleMap.find(nbrNode);
-  Q_ASSERT(it != system.particleMap.end() &&
-           dynamic_cast<ParticleType*>(it->second) != nullptr);
+  AmoebotParticle* nbr = nbrPtrAtLabel(label);
+  Q_ASSERT(nbr != nullptr && dynamic_cast<ParticleType*>(nbr) != nullptr);
 
-  return dynamic_cast<ParticleType&>(*(it->second));
+  // The type is only checked by the assertion above; release builds skip the
+  // RTTI lookup, since a mismatch is a bug in the algorithm either way.
+  return static_cast<ParticleType&>(*nbr);
 }
 
 template<class ParticleType>
@@ -186,82 +385,97 @@ int AmoebotParticle::labelOfFirstNbrWithProperty(
   return -1;
 }
 
+template<class ParticleType>
+unsigned int AmoebotParticle::nbrMaskWithProperty(
+    std::function<bool(const ParticleType&)> propertyCheck) const {
+  return labelMask([&](int label) {
+    return hasNbrAtLabel(label) &&
+           propertyCheck(nbrAtLabel<ParticleType>(label));
+  });
+}
+
+template<class TokenType>
+const AmoebotParticle::TokenTypeInfo* const
+AmoebotParticle::RegisteredTokenType<TokenType>::info =
+    AmoebotParticle::registerTokenType(
+        typeid(TokenType),
+        &AmoebotParticle::RegisteredTokenType<TokenType>::isInstance);
+
+template<class TokenType, class... Args>
+std::shared_ptr<TokenType> AmoebotParticle::makeToken(Args&&... args) {
+  std::shared_ptr<TokenType> token =
+      std::allocate_shared<TokenType>(TokenAllocator<TokenType>(),
+                                      std::forward<Args>(args)...);
+  token->typeInfo = RegisteredTokenType<TokenType>::info;
+  return token;
+}
+
 template<class TokenType>
 std::shared_ptr<TokenType> AmoebotParticle::peekAtToken() const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+  const TokenLocation location = locateToken<TokenType>(nullptr);
+  Q_ASSERT(location.bucket != -1);
+
+  return std::static_pointer_cast<TokenType>(
+      tokenBuckets[location.bucket].entries[location.entry].token);
 }
 
 template<class TokenType>
 std::shared_ptr<TokenType> AmoebotParticle::peekAtToken(
     std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+  const TokenLocation location = locateToken<TokenType>(&propertyCheck);
+  Q_ASSERT(location.bucket != -1);
+
+  return std::static_pointer_cast<TokenType>(
+      tokenBuckets[location.bucket].entries[location.entry].token);
 }
 
 template<class TokenType>
 std::shared_ptr<TokenType> AmoebotParticle::takeToken() {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      std::swap(tokens[0], tokens[i]);
-      tokens.pop_front();
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+  const TokenLocation location = locateToken<TokenType>(nullptr);
+  Q_ASSERT(location.bucket != -1);
+
+  std::shared_ptr<TokenType> token = std::static_pointer_cast<TokenType>(
+      tokenBuckets[location.bucket].entries[location.entry].token);
+  removeToken(location);
+  return token;
 }
 
 template<class TokenType>
 std::shared_ptr<TokenType> AmoebotParticle::takeToken(
     std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      std::swap(tokens[0], tokens[i]);
-      tokens.pop_front();
-      return token;
-    }
-  }
-  Q_ASSERT(false);
+  const TokenLocation location = locateToken<TokenType>(&propertyCheck);
+  Q_ASSERT(location.bucket != -1);
+
+  std::shared_ptr<TokenType> token = std::static_pointer_cast<TokenType>(
+      tokenBuckets[location.bucket].entries[location.entry].token);
+  removeToken(location);
+  return token;
 }
 
 template<class TokenType>
 int AmoebotParticle::countTokens() const {
-  int count = 0;
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      count++;
-    }
-  }
-  return count;
+  const int index = RegisteredTokenType<TokenType>::info->index;
+  return index < static_cast<int>(tokenBuckets.size())
+         ? tokenBuckets[index].count : 0;
 }
 
 template<class TokenType>
 int AmoebotParticle::countTokens(
     std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
+  if (countTokens<TokenType>() == 0) {
+    return 0;
+  }
+
+  const int index = RegisteredTokenType<TokenType>::info->index;
   int count = 0;
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      count++;
+  for (const auto& bucket : tokenBuckets) {
+    if (bucket.head < bucket.entries.size() && bucket.type->countsAs(index)) {
+      for (std::size_t i = bucket.head; i < bucket.entries.size(); ++i) {
+        if (propertyCheck(std::static_pointer_cast<TokenType>(
+                bucket.entries[i].token))) {
+          count++;
+        }
+      }
     }
   }
   return count;
@@ -269,27 +483,60 @@ int AmoebotParticle::countTokens(
 
 template<class TokenType>
 bool AmoebotParticle::hasToken() const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr) {
-      return true;
-    }
-  }
-  return false;
+  return countTokens<TokenType>() > 0;
 }
 
 template<class TokenType>
 bool AmoebotParticle::hasToken(
     std::function<bool(const std::shared_ptr<TokenType>)> propertyCheck) const {
-  for (unsigned int i = 0; i < tokens.size(); i++) {
-    std::shared_ptr<TokenType> token =
-        std::dynamic_pointer_cast<TokenType>(tokens[i]);
-    if (token != nullptr && propertyCheck(token)) {
-      return true;
+  return locateToken<TokenType>(&propertyCheck).bucket != -1;
+}
+
+template<class TokenType>
+AmoebotParticle::TokenLocation AmoebotParticle::locateToken(
+    const std::function<bool(const std::shared_ptr<TokenType>)>*
+    propertyCheck) const {
+  TokenLocation location = {-1, 0};
+  const int index = RegisteredTokenType<TokenType>::info->index;
+  const int count = countTokens<TokenType>();
+  if (count == 0) {
+    return location;
+  }
+
+  // If every token counting as the specified type is exactly of that type, only
+  // its own bucket needs to be searched.
+  const TokenBucket& own = tokenBuckets[index];
+  std::size_t first = 0;
+  std::size_t last = tokenBuckets.size();
+  if (static_cast<std::size_t>(count) == own.entries.size() - own.head) {
+    first = index;
+    last = index + 1;
+  }
+
+  std::uint64_t firstStamp = 0;
+  for (std::size_t b = first; b < last; ++b) {
+    const TokenBucket& bucket = tokenBuckets[b];
+    if (bucket.head == bucket.entries.size() ||
+        !bucket.type->countsAs(index)) {
+      continue;
+    }
+
+    // Stamps increase along a bucket, so the search of this bucket can stop as
+    // soon as it reaches a token after the best one found so far.
+    for (std::size_t e = bucket.head; e < bucket.entries.size(); ++e) {
+      const TokenEntry& entry = bucket.entries[e];
+      if (location.bucket != -1 && entry.stamp >= firstStamp) {
+        break;
+      } else if (propertyCheck == nullptr ||
+                 (*propertyCheck)(
+                     std::static_pointer_cast<TokenType>(entry.token))) {
+        location = {static_cast<int>(b), e};
+        firstStamp = entry.stamp;
+        break;
+      }
     }
   }
-  return false;
+  return location;
 }
 
 #endif  // AMOEBOTSIM_CORE_AMOEBOTPARTICLE_H_
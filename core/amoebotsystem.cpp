@@ -4,18 +4,55 @@
 
 #include "core/amoebotsystem.h"
 
+#include <algorithm>
+
 #include <QDateTime>
 #include <QtGlobal>
 
 #include "core/amoebotparticle.h"
 
-AmoebotSystem::AmoebotSystem() {
-  _counts.push_back(new Count("# Rounds"));
-  _counts.push_back(new Count("# Activations"));
-  _counts.push_back(new Count("# Moves"));
+thread_local bool AmoebotSystem::hasNextSeed = false;
+thread_local uint32_t AmoebotSystem::nextSeed = 0;
+thread_local AmoebotSystem::Engine::Kind AmoebotSystem::nextEngineKind =
+    Engine::Kind::MT19937;
+thread_local AmoebotSystem::ParallelTallies* AmoebotSystem::boundTallies =
+    nullptr;
+
+namespace {
+
+// The offsets (dx, dy) of the 19 nodes within distance 2 of a node.
+const int ballOffsets[19][2] = {
+  {0, 0},
+  {1, 0}, {0, 1}, {-1, 1}, {-1, 0}, {0, -1}, {1, -1},
+  {2, 0}, {1, 1}, {0, 2}, {-1, 2}, {-2, 2}, {-2, 1},
+  {-2, 0}, {-1, -1}, {0, -2}, {1, -2}, {2, -2}, {2, -1}
+};
+
+}  // namespace
+
+AmoebotSystem::AmoebotSystem()
+  : scheduler(new UniformScheduler()),
+    roundEpoch(1),
+    numActivatedThisRound(0),
+    _trackChanges(false),
+    _reportAll(true),
+    _claimStamp(0),
+    _seed(hasNextSeed ? nextSeed : randomSeed()),
+    _rng(_seed, nextEngineKind) {
+  hasNextSeed = false;
+  nextEngineKind = Engine::Kind::MT19937;
+  bindToThread();
+
+  roundsCount = registerCount("# Rounds");
+  activationsCount = registerCount("# Activations");
+  movesCount = registerCount("# Moves");
+  nbrCacheUpdatesCount = registerCount("# Nbr Cache Updates");
 }
 
 AmoebotSystem::~AmoebotSystem() {
+  // The particles' memory is released with the pool's slabs when the pool is
+  // destroyed, so there is no point in recycling their blocks one by one.
+  _pool.beginTeardown();
   for (auto p : particles) {
     delete p;
   }
@@ -26,6 +63,12 @@ AmoebotSystem::~AmoebotSystem() {
   }
   objects.clear();
 
+  // Deleting the particles above removed them from their state tallies, so the
+  // tallies must outlive them.
+  for (auto t : _stateTallies) {
+    delete t;
+  }
+
   for (auto c : _counts) {
     delete c;
   }
@@ -33,24 +76,207 @@ AmoebotSystem::~AmoebotSystem() {
   for (auto m : _measures) {
     delete m;
   }
+
+  // Make sure no later draw on this thread uses the destroyed engine.
+  Engine* bound = bind(nullptr);
+  if (bound != &_rng) {
+    bind(bound);
+  }
 }
 
 void AmoebotSystem::activate() {
+  bindToThread();
   if (particles.size() > 0) {
-    AmoebotParticle* particle = particles.at(randInt(0, particles.size()));
+    AmoebotParticle* particle = particles.at(scheduler->next(particles.size()));
     registerActivation(particle);
     particle->activate();
   }
 }
 
 void AmoebotSystem::activateParticleAt(Node node) {
-  auto it = particleMap.find(node);
-  if (it != particleMap.end()) {
-    registerActivation(it->second);
-    it->second->activate();
+  bindToThread();
+  AmoebotParticle* particle = occupancy.particleAt(node);
+  if (particle != nullptr) {
+    registerActivation(particle);
+    particle->activate();
   }
 }
 
+void AmoebotSystem::activateSynchronousRound(unsigned int numThreads) {
+  Q_ASSERT(supportsSynchronousRounds());
+  Q_ASSERT(numThreads > 0);
+
+  bindToThread();
+  if (particles.empty()) {
+    return;
+  }
+  WorkerPool& pool = workers(numThreads);
+
+  // Read phase.
+  const int numParticles = particles.size();
+  const int numBlocks = (numParticles + syncBlockSize - 1) / syncBlockSize;
+  const uint32_t roundSeed = engine()();
+  const Engine::Kind kind = _rng.kind();
+  pool.run(numBlocks, [&](int block) {
+    Engine blockEngine(roundSeed + block * 0x9E3779B9u, kind);
+    Engine* previous = bind(&blockEngine);
+    const int end = std::min(numParticles, (block + 1) * syncBlockSize);
+    for (int i = block * syncBlockSize; i < end; ++i) {
+      particles[i]->computeNextState();
+    }
+    bind(previous);
+  });
+
+  // Expansions.
+  std::vector<bool> moved(numParticles, false);
+  for (int i = 0; i < numParticles; ++i) {
+    AmoebotParticle* particle = particles[i];
+    if (particle->moveRequest == AmoebotParticle::MoveRequest::Expand &&
+        particle->canExpand(particle->moveRequestLabel)) {
+      particle->expand(particle->moveRequestLabel);
+      moved[i] = true;
+    }
+  }
+
+  // Contractions and write phase.
+  for (int i = 0; i < numParticles; ++i) {
+    AmoebotParticle* particle = particles[i];
+    if (particle->moveRequest == AmoebotParticle::MoveRequest::ContractHead) {
+      particle->contractHead();
+      moved[i] = true;
+    } else if (particle->moveRequest ==
+               AmoebotParticle::MoveRequest::ContractTail) {
+      particle->contractTail();
+      moved[i] = true;
+    }
+    particle->moveRequest = AmoebotParticle::MoveRequest::None;
+    particle->commitNextState(moved[i]);
+  }
+
+  for (int i = 0; i < numParticles; ++i) {
+    registerActivation(particles[i]);
+  }
+}
+
+void AmoebotSystem::activateInParallel(unsigned int numActivations,
+                                       unsigned int numThreads) {
+  Q_ASSERT(supportsParallelActivations());
+  Q_ASSERT(numThreads > 0);
+
+  bindToThread();
+  if (particles.empty()) {
+    return;
+  }
+  WorkerPool& pool = workers(numThreads);
+  const Engine::Kind kind = _rng.kind();
+
+  occupancy.deferReleases();
+  std::vector<AmoebotParticle*> waiting, stillWaiting, wave;
+  unsigned int numDrawn = 0;
+  while (numDrawn < numActivations || !waiting.empty()) {
+    // Collect the next wave, first from the waiting draws and then from new
+    // draws, in the order they were drawn.
+    if (++_claimStamp == 0) {
+      ++_claimStamp;  // Stamp 0 marks unclaimed nodes.
+    }
+    unsigned int numNewInRound = 0;
+    bool waveClosed = false;
+    auto consider = [&](AmoebotParticle* particle) {
+      if (waveClosed || !claimFootprint(*particle)) {
+        stillWaiting.push_back(particle);
+        return;
+      }
+      wave.push_back(particle);
+      if (particle->activationEpoch != roundEpoch) {
+        ++numNewInRound;
+      }
+      waveClosed = wave.size() == maxWaveSize ||
+                   numActivatedThisRound + numNewInRound == particles.size();
+    };
+    for (AmoebotParticle* particle : waiting) {
+      consider(particle);
+    }
+    while (!waveClosed && stillWaiting.size() < maxWaitingDraws &&
+           numDrawn < numActivations) {
+      consider(particles[scheduler->next(particles.size())]);
+      ++numDrawn;
+    }
+    waiting.swap(stillWaiting);
+    stillWaiting.clear();
+
+    // Run the wave.
+    const int waveSize = wave.size();
+    const int numTasks = (waveSize + parallelTaskSize - 1) / parallelTaskSize;
+    if (static_cast<int>(_taskTallies.size()) < numTasks) {
+      _taskTallies.resize(numTasks);
+    }
+    const uint32_t waveSeed = engine()();
+    pool.run(numTasks, [&](int task) {
+      Engine taskEngine(waveSeed + task * 0x9E3779B9u, kind);
+      Engine* previousEngine = bind(&taskEngine);
+      boundTallies = &_taskTallies[task];
+      StateTally::bindLog(&_taskTallies[task].stateChanges);
+      const int end = std::min(waveSize, (task + 1) * parallelTaskSize);
+      for (int i = task * parallelTaskSize; i < end; ++i) {
+        wave[i]->activate();
+      }
+      StateTally::bindLog(nullptr);
+      boundTallies = nullptr;
+      bind(previousEngine);
+    });
+
+    for (int task = 0; task < numTasks; ++task) {
+      ParallelTallies& tallies = _taskTallies[task];
+      movesCount.record(tallies.moves);
+      nbrCacheUpdatesCount.record(tallies.nbrCacheUpdates);
+      StateTally::applyLog(tallies.stateChanges);
+      for (const AmoebotParticle* particle : tallies.changedParticles) {
+        markChanged(particle->systemIndex);
+      }
+      tallies.moves = 0;
+      tallies.nbrCacheUpdates = 0;
+      tallies.stateChanges.clear();
+      tallies.changedParticles.clear();
+    }
+    for (AmoebotParticle* particle : wave) {
+      registerActivation(particle);
+    }
+    wave.clear();
+  }
+  occupancy.endDeferredReleases();
+}
+
+void AmoebotSystem::setNextSeed(const uint32_t seed) {
+  nextSeed = seed;
+  hasNextSeed = true;
+}
+
+uint32_t AmoebotSystem::getSeed() const {
+  return _seed;
+}
+
+void AmoebotSystem::reseed(const uint32_t seed) {
+  _seed = seed;
+  _rng.seed(seed);
+}
+
+void AmoebotSystem::setNextEngineKind(const Engine::Kind kind) {
+  nextEngineKind = kind;
+}
+
+AmoebotSystem::Engine::Kind AmoebotSystem::getEngineKind() const {
+  return _rng.kind();
+}
+
+void AmoebotSystem::setScheduler(const Scheduler::Policy policy,
+                                 const uint32_t seed) {
+  scheduler = Scheduler::create(policy, seed);
+}
+
+Scheduler::Policy AmoebotSystem::getSchedulerPolicy() const {
+  return scheduler->policy();
+}
+
 unsigned int AmoebotSystem::size() const {
   return particles.size();
 }
@@ -63,57 +289,254 @@ const Particle& AmoebotSystem::at(int i) const {
   return *particles.at(i);
 }
 
+const Particle* AmoebotSystem::particleAt(const Node& node) const {
+  return occupancy.particleAt(node);
+}
+
 const std::deque<Object*>& AmoebotSystem::getObjects() const {
   return objects;
 }
 
+void AmoebotSystem::takeChangedParticles(std::vector<int>& indices) {
+  startTrackingChanges();
+  for (const int i : _changedParticles) {
+    _isChanged[i] = false;
+    if (!_reportAll && i < static_cast<int>(particles.size())) {
+      indices.push_back(i);
+    }
+  }
+  _changedParticles.clear();
+
+  if (_reportAll) {
+    _reportAll = false;
+    System::takeChangedParticles(indices);
+  }
+}
+
+Appearance AmoebotSystem::appearanceAt(int i) {
+  Q_ASSERT(0 <= i && i < static_cast<int>(particles.size()));
+
+  startTrackingChanges();
+  if (_isAppearanceStale[i]) {
+    _appearances[i] = particles[i]->appearance();
+    _isAppearanceStale[i] = false;
+  }
+  return _appearances[i];
+}
+
 void AmoebotSystem::insert(AmoebotParticle* particle) {
-  Q_ASSERT(particleMap.find(particle->head) == particleMap.end());
-  Q_ASSERT(objectMap.find(particle->head) == objectMap.end());
+  Q_ASSERT(occupancy.particleAt(particle->head) == nullptr);
+  Q_ASSERT(occupancy.objectAt(particle->head) == nullptr);
   Q_ASSERT(!particle->isExpanded() ||
-           particleMap.find(particle->tail()) == particleMap.end());
+           (occupancy.particleAt(particle->tail()) == nullptr &&
+            occupancy.objectAt(particle->tail()) == nullptr));
 
+  particle->systemIndex = particles.size();
   particles.push_back(particle);
-  particleMap[particle->head] = particle;
+  setOccupant(particle->head, particle);
   if (particle->isExpanded()) {
-    particleMap[particle->tail()] = particle;
+    setOccupant(particle->tail(), particle);
   }
+  refreshNbrCache(*particle);
+  if (_trackChanges) {
+    _appearances.emplace_back();
+    _isAppearanceStale.push_back(true);
+  }
+  markChanged(*particle);
 }
 
 void AmoebotSystem::insert(Object* object) {
-  Q_ASSERT(objectMap.find(object->_node) == objectMap.end());
-  Q_ASSERT(particleMap.find(object->_node) == particleMap.end());
+  Q_ASSERT(occupancy.objectAt(object->_node) == nullptr);
+  Q_ASSERT(occupancy.particleAt(object->_node) == nullptr);
 
   objects.push_back(object);
-  objectMap[object->_node] = object;
+  occupancy.setObject(object->_node, object);
 }
 
 void AmoebotSystem::remove(AmoebotParticle* particle) {
-  particles.erase(std::remove(particles.begin(), particles.end(), particle),
-                  particles.end());
-  auto it = particleMap.begin();
-  while (it != particleMap.end()) {
-    if (it->second == particle) {
-      it = particleMap.erase(it);
-    } else {
-      it++;
-    }
+  Q_ASSERT(0 <= particle->systemIndex &&
+           particle->systemIndex < static_cast<int>(particles.size()) &&
+           particles[particle->systemIndex] == particle);
+
+  AmoebotParticle* last = particles.back();
+  particles[particle->systemIndex] = last;
+  last->systemIndex = particle->systemIndex;
+  particles.pop_back();
+  if (_trackChanges) {
+    _appearances.pop_back();
+    _isAppearanceStale.pop_back();
+  }
+  if (last != particle) {
+    markChanged(last->systemIndex);
+  }
+  particle->systemIndex = -1;
+
+  clearOccupant(particle->head);
+  if (particle->isExpanded()) {
+    clearOccupant(particle->tail());
+  }
+  particle->nbrCacheValid = false;
+  if (particle->activationEpoch == roundEpoch) {
+    --numActivatedThisRound;
   }
-  activatedParticles.erase(particle);
 
   delete particle;
 }
 
+void AmoebotSystem::setOccupant(const Node& node, AmoebotParticle* particle) {
+  occupancy.setParticle(node, particle);
+  updateAdjacentNbrCaches(node, particle);
+}
+
+void AmoebotSystem::clearOccupant(const Node& node) {
+  occupancy.clearParticle(node);
+  updateAdjacentNbrCaches(node, nullptr);
+}
+
+void AmoebotSystem::refreshNbrCache(AmoebotParticle& particle) {
+  for (int dir = 0; dir < 6; ++dir) {
+    particle.nbrCache[0][dir] =
+        occupancy.particleAt(particle.head.nodeInDir(dir));
+  }
+  if (particle.isExpanded()) {
+    const Node tail = particle.tail();
+    for (int dir = 0; dir < 6; ++dir) {
+      particle.nbrCache[1][dir] = occupancy.particleAt(tail.nodeInDir(dir));
+    }
+  }
+  particle.nbrCacheValid = true;
+}
+
+void AmoebotSystem::markChanged(int index) {
+  if (!_trackChanges || index < 0) {
+    return;
+  } else if (index >= static_cast<int>(_isChanged.size())) {
+    _isChanged.resize(std::max<size_t>(index + 1, 2 * _isChanged.size()));
+  }
+
+  if (!_isChanged[index]) {
+    _isChanged[index] = true;
+    _changedParticles.push_back(index);
+  }
+  _isAppearanceStale[index] = true;
+}
+
+void AmoebotSystem::markChanged(const AmoebotParticle& particle) {
+  if (!_trackChanges) {
+    return;
+  }
+
+  markChanged(particle.systemIndex);
+  const Node nodes[2] = {particle.head,
+                         particle.isExpanded() ? particle.tail() : Node()};
+  for (int part = 0; part < (particle.isExpanded() ? 2 : 1); ++part) {
+    for (int dir = 0; dir < 6; ++dir) {
+      const AmoebotParticle* nbr = particle.nbrCacheValid
+          ? particle.nbrCache[part][dir]
+          : occupancy.particleAt(nodes[part].nodeInDir(dir));
+      if (nbr != nullptr && nbr != &particle) {
+        markChanged(nbr->systemIndex);
+      }
+    }
+  }
+}
+
+void AmoebotSystem::startTrackingChanges() {
+  if (!_trackChanges) {
+    _trackChanges = true;
+    _appearances.resize(particles.size());
+    _isAppearanceStale.assign(particles.size(), true);
+  }
+}
+
+void AmoebotSystem::updateAdjacentNbrCaches(const Node& node,
+                                            AmoebotParticle* occupant) {
+  // The particle adjacent to node in direction dir sees node in the opposite
+  // direction from whichever of its nodes is adjacent.
+  unsigned int numUpdates = 0;
+  for (int dir = 0; dir < 6; ++dir) {
+    const Node adjacent = node.nodeInDir(dir);
+    AmoebotParticle* particle = occupancy.particleAt(adjacent);
+    if (particle != nullptr && particle->nbrCacheValid) {
+      const int part = (particle->head == adjacent) ? 0 : 1;
+      particle->nbrCache[part][(dir + 3) % 6] = occupant;
+      ++numUpdates;
+      if (!_trackChanges) {
+        continue;
+      } else if (boundTallies != nullptr) {
+        boundTallies->changedParticles.push_back(particle);
+      } else {
+        markChanged(particle->systemIndex);
+      }
+    }
+  }
+
+  if (boundTallies != nullptr) {
+    boundTallies->nbrCacheUpdates += numUpdates;
+  } else {
+    nbrCacheUpdatesCount.record(numUpdates);
+  }
+}
+
+WorkerPool& AmoebotSystem::workers(unsigned int numThreads) {
+  if (_workers == nullptr || _workers->numThreads() != numThreads) {
+    _workers.reset(new WorkerPool(numThreads));
+  }
+  return *_workers;
+}
+
+bool AmoebotSystem::claimFootprint(const AmoebotParticle& particle) {
+  _footprint.clear();
+  const int numNodes = particle.isExpanded() ? 2 : 1;
+  const Node nodes[2] = {particle.head,
+                         (numNodes == 2) ? particle.tail() : particle.head};
+  for (int i = 0; i < numNodes; ++i) {
+    for (const auto& offset : ballOffsets) {
+      const Node node(nodes[i].x + offset[0], nodes[i].y + offset[1]);
+      _footprint.push_back(node);
+      const AmoebotParticle* occupant = occupancy.particleAt(node);
+      if (occupant != nullptr && occupant->isExpanded()) {
+        _footprint.push_back(occupant->head);
+        _footprint.push_back(occupant->tail());
+      }
+    }
+  }
+
+  bool isFree = true;
+  for (const Node& node : _footprint) {
+    isFree = isFree && !occupancy.isClaimed(node, _claimStamp);
+  }
+  for (const Node& node : _footprint) {
+    occupancy.claim(node, _claimStamp);
+  }
+
+  return isFree;
+}
+
+void AmoebotSystem::bindToThread() {
+  bind(&_rng);
+  ParticlePool::bind(&_pool);
+}
+
 void AmoebotSystem::registerMovement(unsigned int numMoves) {
-  getCount("# Moves").record(numMoves);
+  if (boundTallies != nullptr) {
+    boundTallies->moves += numMoves;
+  } else {
+    movesCount.record(numMoves);
+  }
 }
 
 void AmoebotSystem::registerActivation(AmoebotParticle* particle) {
-  getCount("# Activations").record();
-  activatedParticles.insert(particle);
-  if (activatedParticles.size() == particles.size()) {
+  activationsCount.record();
+  if (particle->activationEpoch != roundEpoch) {
+    particle->activationEpoch = roundEpoch;
+    ++numActivatedThisRound;
+  }
+  markChanged(*particle);
+  if (numActivatedThisRound == particles.size()) {
     registerRound();
-    activatedParticles.clear();
+    ++roundEpoch;
+    numActivatedThisRound = 0;
   }
 }
 
@@ -121,12 +544,36 @@ void AmoebotSystem::registerRound() {
   for (const auto& c : _counts) {
     c->_history.push_back(c->_value);
   }
+  const unsigned int numRounds = roundsCount.count()._value;
   for (const auto& m : _measures) {
-    if (getCount("# Rounds")._value % m->_freq == 0) {
+    if (numRounds % m->_freq == 0) {
       m->_history.push_back(m->calculate());
     }
   }
-  getCount("# Rounds").record();
+  roundsCount.record();
+}
+
+CountHandle AmoebotSystem::registerCount(const QString name) {
+  _counts.push_back(new Count(name));
+  return CountHandle(_counts.back());
+}
+
+CountHandle AmoebotSystem::countHandle(const QString name) const {
+  return CountHandle(&getCount(name));
+}
+
+StateTally& AmoebotSystem::registerStateTally(const QString name) {
+  _stateTallies.push_back(new StateTally(name));
+  return *_stateTallies.back();
+}
+
+StateTally& AmoebotSystem::getStateTally(const QString name) const {
+  for (const auto& t : _stateTallies) {
+    if (QString::compare(t->_name, name) == 0) {
+      return *t;
+    }
+  }
+  Q_ASSERT(false);  // Requested state tally does not exist.
 }
 
 const std::vector<Count*>& AmoebotSystem::getCounts() const {
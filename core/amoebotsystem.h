@@ -8,16 +8,21 @@
 #ifndef AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
 #define AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
 
+#include <cstdint>
 #include <deque>
-#include <map>
-#include <set>
+#include <memory>
 #include <vector>
 
 #include <QString>
 
 #include "core/metric.h"
 #include "core/object.h"
+#include "core/occupancyindex.h"
+#include "core/particlepool.h"
+#include "core/scheduler.h"
+#include "core/statetally.h"
 #include "core/system.h"
+#include "core/workerpool.h"
 #include "helper/randomnumbergenerator.h"
 
 // AmoebotParticle must be forward declared to avoid a cyclic dependency.
@@ -28,18 +33,86 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
 
  public:
   // Constructs a new particle system with fresh round, activation, and movement
-  // counts.
+  // counts. The system's random number engine is of the kind set by
+  // setNextEngineKind (mt19937 by default) and is seeded with the seed set by
+  // setNextSeed, or with a random seed if there is none. It is bound to the
+  // calling thread so that the subclass constructor's draws come from it. The
+  // system's particle pool is bound likewise, so that the particles the
+  // subclass constructor creates are allocated from it.
   AmoebotSystem();
 
   // Deletes the particles, objects, and metrics in this system before
   // destructing the system.
   virtual ~AmoebotSystem();
 
-  // Functions for activating a particle in the system. activate activates a
-  // random particle in the system, while activateParticleAt activates the
-  // particle occupying the specified node if such a particle exists.
-  void activate() final;
-  void activateParticleAt(Node node) final;
+  // Functions for activating a particle in the system. activate activates the
+  // particle chosen by the system's scheduler (a uniformly random particle by
+  // default), while activateParticleAt activates the particle occupying the
+  // specified node if such a particle exists. Both bind
+  // this system's random number engine and particle pool to the calling thread
+  // first. AmoebotSystemT overrides both to call its particles' activate
+  // statically.
+  void activate() override;
+  void activateParticleAt(Node node) override;
+
+  // Runs one synchronous round on the given number of threads; the system's
+  // particles must implement AmoebotParticle::computeNextState and
+  // commitNextState. First, every particle computes its next state from the
+  // current states (the read phase). The particles are split into blocks of
+  // fixed size, which run in parallel, and each block draws its random numbers
+  // from its own engine seeded from this system's engine, so the outcome does
+  // not depend on the number of threads. Next, the requested expansions are
+  // carried out in the order of the particle list; an expansion fails if its
+  // node was occupied at the start of the round or claimed by an earlier
+  // particle. Finally, the requested contractions, which cannot conflict, are
+  // carried out and every particle commits its next state (the write phase) in
+  // the order of the particle list. Each particle counts as activated once.
+  void activateSynchronousRound(unsigned int numThreads) override;
+
+  // Performs the given number of activations of particles chosen by the
+  // system's scheduler on the given number of threads, with the same outcome as
+  // activating the drawn particles one after another in the order they were
+  // drawn. To this end, an activation
+  // may only read and write the particles occupying nodes within distance 2 of
+  // its particle and the nodes themselves; it must neither insert nor remove
+  // particles nor record counts other than the system's moves, but may change
+  // tracked states. The draws are grouped into waves. Every draw claims the
+  // nodes within distance 2 of its particle together with the nodes of the
+  // particles occupying them, and joins the current wave unless one of these
+  // nodes is already claimed by an earlier draw, in which case it waits for a
+  // later wave. The activations of a wave thus never touch the same particle
+  // and run concurrently in tasks of fixed size; each task draws its random
+  // numbers from its own engine seeded from this system's engine, so the
+  // outcome does not depend on the number of threads. Rounds are counted in the
+  // order the activations are carried out, in which a waiting draw follows the
+  // later draws that overtook it; a wave ends with the activation completing
+  // the current round, so each round's measures see exactly the activations up
+  // to the round's end in this order. Termination is not checked between the
+  // activations.
+  void activateInParallel(unsigned int numActivations,
+                          unsigned int numThreads) override;
+
+  // Functions for controlling the system's random number engine. Systems draw
+  // random numbers while they are constructed (e.g., to place particles), so
+  // setNextSeed sets the seed of the next system constructed on the calling
+  // thread; it applies to that system only. getSeed returns the seed this
+  // system's engine was last seeded with, and reseed restarts the engine from
+  // the given seed. Likewise, setNextEngineKind sets the kind of engine of the
+  // next system constructed on the calling thread, and getEngineKind returns
+  // the kind of this system's engine.
+  static void setNextSeed(const uint32_t seed);
+  uint32_t getSeed() const;
+  void reseed(const uint32_t seed);
+  static void setNextEngineKind(const Engine::Kind kind);
+  Engine::Kind getEngineKind() const;
+
+  // Replaces the system's scheduler by a new one of the given policy (see
+  // scheduler.h); the seed is only used by the adversarial policy. The
+  // policy's order starts over, so a permutation covers whole rounds only if
+  // selected when a round begins, e.g., before the first activation.
+  void setScheduler(const Scheduler::Policy policy,
+                    const uint32_t seed = 0) final;
+  Scheduler::Policy getSchedulerPolicy() const;
 
   // Returns the number of particles in the system.
   unsigned int size() const final;
@@ -50,16 +123,47 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
   // Returns a reference to the particle at the specified index of particles.
   const Particle& at(int i) const final;
 
+  // Returns the particle occupying the given node, looked up in the occupancy
+  // index in constant time, or nullptr if the node is unoccupied.
+  const Particle* particleAt(const Node& node) const final;
+
   // Returns a reference to the object list.
   virtual const std::deque<Object*>& getObjects() const final;
 
+  // Functions for drawing the particles. A particle's appearance may change
+  // when it is inserted or activated, when an adjacent particle is activated
+  // (the activation is registered before the particle acts in sequential
+  // activations and after it has acted in parallel ones), and when the
+  // occupant of an adjacent node changes; refilling a removed particle's slot
+  // changes the slot's appearance. takeChangedParticles appends the indices of
+  // the particles that changed in any of these ways since the last call.
+  // appearanceAt returns the appearance of the particle at the given index
+  // from a cache, recomputing it only if the particle changed since it was
+  // last computed. Changes are only tracked from the first call to either
+  // function on, so systems nobody draws pay nothing for this; the first call
+  // of takeChangedParticles appends every particle.
+  void takeChangedParticles(std::vector<int>& indices) final;
+  Appearance appearanceAt(int i) final;
+
+  // Records that the appearance of the given particle and its neighbors may
+  // have changed, so that the next call of takeChangedParticles appends them
+  // and appearanceAt recomputes their appearance once. Only the changes listed
+  // above are tracked, so an algorithm whose activations write to the state of
+  // particles other than the activated particle's neighbors (e.g., by passing a
+  // message along a chain of particles) must call this for each particle it
+  // writes to. Must not be called from the read phase of synchronous rounds or
+  // from parallel activations.
+  void markChanged(const AmoebotParticle& particle);
+
   // Inserts a particle or an object, respectively, into the system. A particle
   // can be contracted or expanded. Fails if the respective node(s) are already
   // occupied.
   void insert(AmoebotParticle* particle);
   void insert(Object* object);
 
-  // Removes the specified particle from the system.
+  // Removes the specified particle from the system and deletes it. Takes
+  // constant time: the last particle in the particle list is moved into the
+  // removed particle's slot, so the order of the remaining particles changes.
   void remove(AmoebotParticle* particle);
 
   // Functions for logging system progress. registerMovement logs the given
@@ -67,16 +171,41 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
   // given particle has been activated. When all particles have been activated
   // at least once, this resets its logging and triggers registerRound(), which
   // commits all counts and measures to their histories and increments the
-  // number of completed asynchronous rounds by one.
+  // number of completed asynchronous rounds by one. A particle counts as
+  // activated in the current round if its activation stamp equals the current
+  // round epoch, so starting a new round only requires incrementing the epoch.
   void registerMovement(unsigned int numMoves = 1);
   void registerActivation(AmoebotParticle* particle);
   void registerRound();
 
+  // Functions for registering metrics. registerCount creates a count with the
+  // given name and returns a handle to it; recording through the handle is a
+  // plain integer addition, so particles should keep the handle rather than
+  // calling getCount on every event. registerMeasure takes ownership of the
+  // given measure and returns it with its own type. countHandle looks up an
+  // already registered count by name; like getCount, it is meant to be called
+  // once (e.g., in a constructor), not per event.
+  CountHandle registerCount(const QString name);
+  template<class MeasureType>
+  MeasureType& registerMeasure(MeasureType* measure);
+  CountHandle countHandle(const QString name) const;
+
+  // Functions for incremental termination detection. registerStateTally
+  // creates a named tally of how many particles hold each value of some state
+  // variable; particles store that variable as a TrackedState bound to the
+  // tally, so hasTerminated can test the tally in constant time instead of
+  // scanning all particles. getStateTally looks up a registered tally by name;
+  // it crashes if the tally is not found and, like countHandle, is meant to be
+  // called once per particle (e.g., in its constructor).
+  StateTally& registerStateTally(const QString name);
+  StateTally& getStateTally(const QString name) const;
+
   // Various access functions for metrics (counts and measures). getCounts
   // (resp., getMeasures) returns a reference to the count (resp., measure)
   // list. getCount (resp., getMeasure) returns a reference to the named count
   // (resp., measure). These functions crash if the requested count/measure is
-  // not found!
+  // not found! Their name lookups are slow paths intended for scripts and the
+  // GUI; see registerCount for recording counts during algorithm execution.
   const std::vector<Count*>& getCounts() const final;
   const std::vector<Measure*>& getMeasures() const final;
   Count& getCount(QString name) const final;
@@ -87,13 +216,101 @@ class AmoebotSystem : public System, public RandomNumberGenerator {
   const QString metricsAsJSON() const final;
 
  protected:
+  // Binds this system's random number engine and particle pool to the calling
+  // thread, so that subsequent draws and particle allocations use them.
+  void bindToThread();
+
   std::vector<AmoebotParticle*> particles;
-  std::map<Node, AmoebotParticle*> particleMap;
-  std::set<AmoebotParticle*> activatedParticles;
+  std::unique_ptr<Scheduler> scheduler;
+  unsigned int roundEpoch;
+  unsigned int numActivatedThisRound;
   std::deque<Object*> objects;
-  std::map<Node, Object*> objectMap;
+  OccupancyIndex occupancy;
   std::vector<Count*> _counts;
   std::vector<Measure*> _measures;
+  std::vector<StateTally*> _stateTallies;
+
+ private:
+  // Functions maintaining the occupancy index together with the particles'
+  // neighbor caches. setOccupant (resp., clearOccupant) records that the given
+  // particle (resp., no particle) occupies the given node and updates the
+  // cached slot of every particle adjacent to that node. Particles whose own
+  // position changed must then be refreshed with refreshNbrCache, which
+  // recomputes all of the given particle's slots and marks its cache valid.
+  void setOccupant(const Node& node, AmoebotParticle* particle);
+  void clearOccupant(const Node& node);
+  void refreshNbrCache(AmoebotParticle& particle);
+  void updateAdjacentNbrCaches(const Node& node, AmoebotParticle* occupant);
+
+  // Records that the appearance of the particle at the given index of the
+  // particle list may have changed, if changes are tracked and the particle has
+  // not been removed; see takeChangedParticles.
+  // startTrackingChanges starts tracking them, with every particle changed.
+  void markChanged(int index);
+  void startTrackingChanges();
+
+  bool _trackChanges;
+  bool _reportAll;  // Whether takeChangedParticles appends every particle.
+  std::vector<int> _changedParticles;
+  std::vector<bool> _isChanged;  // Indexed like particles.
+  std::vector<Appearance> _appearances;  // Likewise, if changes are tracked.
+  std::vector<bool> _isAppearanceStale;  // Likewise.
+
+  // Returns the worker threads running the parallel parts of synchronous rounds
+  // and parallel activations, (re)creating them for the given number of threads
+  // if necessary.
+  WorkerPool& workers(unsigned int numThreads);
+
+  // The number of particles per block of a synchronous round's read phase.
+  static const int syncBlockSize = 256;
+  std::unique_ptr<WorkerPool> _workers;
+
+  // Functions and state for parallel activations. claimFootprint claims the
+  // nodes an activation of the given particle may touch with the current claim
+  // stamp and returns true if and only if none of them was claimed before.
+  // While a task of a wave runs, the moves and neighbor cache updates it makes
+  // are added up in its ParallelTallies (bound to its thread) together with
+  // its state tally changes and the particles next to its moves, and applied
+  // once the wave has finished.
+  struct ParallelTallies {
+    unsigned int moves = 0;
+    unsigned int nbrCacheUpdates = 0;
+    std::vector<StateTally::Change> stateChanges;
+    std::vector<const AmoebotParticle*> changedParticles;
+  };
+  bool claimFootprint(const AmoebotParticle& particle);
+
+  static const int parallelTaskSize = 32;
+  static const unsigned int maxWaveSize = 1024;
+  static const unsigned int maxWaitingDraws = 4096;
+  unsigned int _claimStamp;
+  std::vector<Node> _footprint;
+  std::vector<ParallelTallies> _taskTallies;
+  static thread_local ParallelTallies* boundTallies;
+
+  // Pending seed for the next system constructed on each thread, if any.
+  static thread_local bool hasNextSeed;
+  static thread_local uint32_t nextSeed;
+  static thread_local Engine::Kind nextEngineKind;
+
+  uint32_t _seed;
+  Engine _rng;
+  ParticlePool _pool;
+
+  // Handles to the default counts every system records. The neighbor cache
+  // update count records how many slots of neighbor caches were updated because
+  // a node's occupant changed (see AmoebotParticle's nbrCache); divided by the
+  // number of moves, it is the cache maintenance cost per move.
+  CountHandle roundsCount;
+  CountHandle activationsCount;
+  CountHandle movesCount;
+  CountHandle nbrCacheUpdatesCount;
 };
 
+template<class MeasureType>
+MeasureType& AmoebotSystem::registerMeasure(MeasureType* measure) {
+  _measures.push_back(measure);
+  return *measure;
+}
+
 #endif  // AMOEBOTSIM_CORE_AMOEBOTSYSTEM_H_
@@ -0,0 +1,87 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines an opt-in variant of AmoebotSystem for algorithms whose particles all
+// have the same concrete type ParticleT. Such a system activates its particles
+// by calling ParticleT::activate directly instead of through the vtable, and
+// hands out its particles with their concrete type without any RTTI. It is an
+// AmoebotSystem in every other respect, so the GUI, Simulator, and scripts use
+// it through the System interface unchanged. Particles are still allocated
+// individually, but from the system's particle pool, so they are stored
+// contiguously (see ParticlePool).
+//
+// ParticleT must be the exact type of every particle in the system (not a base
+// class of it), since ParticleT::activate is called statically; this is checked
+// on insertion in debug builds.
+
+#ifndef AMOEBOTSIM_CORE_AMOEBOTSYSTEMT_H_
+#define AMOEBOTSIM_CORE_AMOEBOTSYSTEMT_H_
+
+#include <typeinfo>
+
+#include <QtGlobal>
+
+#include "core/amoebotparticle.h"
+#include "core/amoebotsystem.h"
+#include "core/node.h"
+#include "core/object.h"
+
+template<class ParticleT>
+class AmoebotSystemT : public AmoebotSystem {
+ public:
+  // Activate the scheduled particle (resp., the particle occupying the given
+  // node) exactly like AmoebotSystem does, including its random draws, but call
+  // ParticleT::activate statically.
+  void activate() override;
+  void activateParticleAt(Node node) override;
+
+  // Returns the particle at the specified index of the particle list with its
+  // concrete type.
+  ParticleT& particle(int i) const;
+
+  // Inserts a particle of this system's particle type or an object,
+  // respectively; see AmoebotSystem::insert.
+  void insert(ParticleT* particle);
+  void insert(Object* object);
+};
+
+template<class ParticleT>
+void AmoebotSystemT<ParticleT>::activate() {
+  bindToThread();
+  if (particles.size() > 0) {
+    ParticleT* p =
+        static_cast<ParticleT*>(particles[scheduler->next(particles.size())]);
+    registerActivation(p);
+    p->ParticleT::activate();
+  }
+}
+
+template<class ParticleT>
+void AmoebotSystemT<ParticleT>::activateParticleAt(Node node) {
+  bindToThread();
+  AmoebotParticle* p = occupancy.particleAt(node);
+  if (p != nullptr) {
+    registerActivation(p);
+    static_cast<ParticleT*>(p)->ParticleT::activate();
+  }
+}
+
+template<class ParticleT>
+ParticleT& AmoebotSystemT<ParticleT>::particle(int i) const {
+  Q_ASSERT(0 <= i && i < static_cast<int>(particles.size()));
+  return *static_cast<ParticleT*>(particles[i]);
+}
+
+template<class ParticleT>
+void AmoebotSystemT<ParticleT>::insert(ParticleT* particle) {
+  Q_ASSERT(typeid(*particle) == typeid(ParticleT));
+  AmoebotSystem::insert(particle);
+}
+
+template<class ParticleT>
+void AmoebotSystemT<ParticleT>::insert(Object* object) {
+  AmoebotSystem::insert(object);
+}
+
+#endif  // AMOEBOTSIM_CORE_AMOEBOTSYSTEMT_H_
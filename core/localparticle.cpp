@@ -4,32 +4,122 @@
 
 #include "core/localparticle.h"
 
-const std::vector<int> LocalParticle::sixLabels = {
-  {0, 1, 2, 3, 4, 5}
+namespace {
+
+// All label geometry depends only on whether the particle is contracted and, if
+// it is expanded, on the local direction of its tail, so it is tabulated here
+// once and indexed by that tail direction. Lists of labels are handed out as
+// LabelSpans into these tables.
+
+constexpr int sixLabels[6] = {0, 1, 2, 3, 4, 5};
+
+// The labels of edges incident to the head of an expanded particle (or, after
+// adding 3 to the tail direction, to its tail), in counter-clockwise order.
+constexpr int labels[6][5] = {
+  {3, 4, 5, 6, 7},
+  {4, 5, 6, 7, 8},
+  {7, 8, 9, 0, 1},
+  {8, 9, 0, 1, 2},
+  {9, 0, 1, 2, 3},
+  {2, 3, 4, 5, 6}
 };
 
-const std::array<const std::vector<int>, 6> LocalParticle::labels = {
-  {{3, 4, 5, 6, 7},
-   {4, 5, 6, 7, 8},
-   {7, 8, 9, 0, 1},
-   {8, 9, 0, 1, 2},
-   {9, 0, 1, 2, 3},
-   {2, 3, 4, 5, 6}}
+// The masks of the label lists above.
+constexpr unsigned int labelMasks[6] = {
+  0x0F8, 0x1F0, 0x383, 0x307, 0x20F, 0x07C
 };
 
-const std::array<int, 6> LocalParticle::contractLabels = {
-  {0, 1, 4, 5, 6, 9}
+// The labels which uniquely address the nodes neighboring an expanded particle,
+// i.e., all labels but the first head label and the first tail label, which
+// reach the same nodes as the labels preceding them.
+constexpr int uniqueLabelLists[6][8] = {
+  {0, 1, 2, 4, 5, 6, 7, 9},
+  {0, 1, 2, 3, 5, 6, 7, 8},
+  {0, 1, 3, 4, 5, 6, 8, 9},
+  {0, 1, 2, 4, 5, 6, 7, 9},
+  {0, 1, 2, 3, 5, 6, 7, 8},
+  {0, 1, 3, 4, 5, 6, 8, 9}
 };
 
-const std::array<std::array<int, 10>, 6> LocalParticle::labelDir = {
-  {{{0, 1, 2, 1, 2, 3, 4, 5, 4, 5}},
-   {{0, 1, 2, 3, 2, 3, 4, 5, 0, 5}},
-   {{0, 1, 0, 1, 2, 3, 4, 3, 4, 5}},
-   {{0, 1, 2, 1, 2, 3, 4, 5, 4, 5}},
-   {{0, 1, 2, 3, 2, 3, 4, 5, 0, 5}},
-   {{0, 1, 0, 1, 2, 3, 4, 3, 4, 5}}}
+// The masks of the unique label lists above.
+constexpr unsigned int uniqueLabelMasks[6] = {
+  0x2F7, 0x1EF, 0x37B, 0x2F7, 0x1EF, 0x37B
 };
 
+constexpr int contractLabels[6] = {0, 1, 4, 5, 6, 9};
+
+// The local direction each label points to.
+constexpr int labelDir[6][10] = {
+  {0, 1, 2, 1, 2, 3, 4, 5, 4, 5},
+  {0, 1, 2, 3, 2, 3, 4, 5, 0, 5},
+  {0, 1, 0, 1, 2, 3, 4, 3, 4, 5},
+  {0, 1, 2, 1, 2, 3, 4, 5, 4, 5},
+  {0, 1, 2, 3, 2, 3, 4, 5, 0, 5},
+  {0, 1, 0, 1, 2, 3, 4, 3, 4, 5}
+};
+
+// The inverses of labelDir restricted to the head (resp., tail) labels, i.e.,
+// the head (resp., tail) label pointing in each local direction; -1 marks the
+// direction of the edge between head and tail, which has no label.
+constexpr int dirHeadLabel[6][6] = {
+  {-1, 3, 4, 5, 6, 7},
+  {8, -1, 4, 5, 6, 7},
+  {0, 1, -1, 7, 8, 9},
+  {0, 1, 2, -1, 8, 9},
+  {0, 1, 2, 3, -1, 9},
+  {2, 3, 4, 5, 6, -1}
+};
+
+constexpr int dirTailLabel[6][6] = {
+  {0, 1, 2, -1, 8, 9},
+  {0, 1, 2, 3, -1, 9},
+  {2, 3, 4, 5, 6, -1},
+  {-1, 3, 4, 5, 6, 7},
+  {8, -1, 4, 5, 6, 7},
+  {0, 1, -1, 7, 8, 9}
+};
+
+// Computes the number of maximal runs of consecutive set bits around a ring of
+// the given size for every mask on that ring.
+template<std::size_t numMasks>
+std::array<unsigned char, numMasks> computeMaskRuns(const int ringSize) {
+  std::array<unsigned char, numMasks> runs;
+  for (unsigned int mask = 0; mask < numMasks; ++mask) {
+    runs[mask] = 0;
+    for (int bit = 0; bit < ringSize; ++bit) {
+      const int prevBit = (bit + ringSize - 1) % ringSize;
+      if ((mask >> bit & 1) && !(mask >> prevBit & 1)) {
+        ++runs[mask];
+      }
+    }
+    if (mask == numMasks - 1) {
+      runs[mask] = 1;  // A full ring is one run without a start.
+    }
+  }
+
+  return runs;
+}
+
+std::array<unsigned char, 1024> computeMaskSizes() {
+  std::array<unsigned char, 1024> sizes;
+  for (unsigned int mask = 0; mask < 1024; ++mask) {
+    sizes[mask] = (mask & 1) + ((mask == 0) ? 0 : sizes[mask >> 1]);
+  }
+
+  return sizes;
+}
+
+}  // namespace
+
+const std::array<unsigned char, 1024> LocalParticle::maskSizes =
+    computeMaskSizes();
+
+const std::array<unsigned char, 64> LocalParticle::maskRuns6 =
+    computeMaskRuns<64>(6);
+
+const std::array<unsigned char, 1024> LocalParticle::maskRuns10 =
+    computeMaskRuns<1024>(10);
+
 LocalParticle::LocalParticle(const Node& head, int globalTailDir,
                              const int orientation)
   : Particle(head, globalTailDir),
@@ -63,84 +153,143 @@ int LocalParticle::labelToDirAfterExpansion(int label, int expansionDir) const {
   return labelDir[(expansionDir + 3) % 6][label];
 }
 
-const std::vector<int> LocalParticle::uniqueLabels() const {
-  std::vector<int> labels;
+LabelSpan LocalParticle::uniqueLabels() const {
   if (isContracted()) {
-    labels = sixLabels;
+    return LabelSpan(sixLabels, 6);
   } else { // isExpanded().
-    for (int label = 0; label < 10; ++label) {
-      if (nbrNodeReachedViaLabel(label) !=
-          nbrNodeReachedViaLabel((label + 9) % 10)) {
-        labels.push_back(label);
-      }
-    }
+    return LabelSpan(uniqueLabelLists[tailDir()], 8);
+  }
+}
+
+int LocalParticle::numLabels() const {
+  return isContracted() ? 6 : 10;
+}
+
+unsigned int LocalParticle::uniqueLabelMask() const {
+  return isContracted() ? 0x3F : uniqueLabelMasks[tailDir()];
+}
+
+unsigned int LocalParticle::headLabelMask() const {
+  return isContracted() ? 0x3F : labelMasks[tailDir()];
+}
+
+unsigned int LocalParticle::tailLabelMask() const {
+  Q_ASSERT(isExpanded());
+
+  return labelMasks[(tailDir() + 3) % 6];
+}
+
+unsigned int LocalParticle::labelsToMask(const std::vector<int>& labels) {
+  return labelsToMask(LabelSpan(labels.data(), labels.size()));
+}
+
+unsigned int LocalParticle::labelsToMask(LabelSpan labels) {
+  unsigned int mask = 0;
+  for (const int label : labels) {
+    Q_ASSERT(0 <= label && label < 10);
+    mask |= 1u << label;
+  }
+
+  return mask;
+}
+
+int LocalParticle::maskSize(unsigned int mask) {
+  Q_ASSERT(mask < 1024);
+
+  return maskSizes[mask];
+}
+
+int LocalParticle::maskRuns(unsigned int mask, int ringSize) {
+  Q_ASSERT(ringSize == 6 || ringSize == 10);
+  Q_ASSERT(mask < (1u << ringSize));
+
+  return (ringSize == 6) ? maskRuns6[mask] : maskRuns10[mask];
+}
+
+unsigned int LocalParticle::rotateMask(unsigned int mask, int offset,
+                                       int ringSize) {
+  Q_ASSERT(ringSize == 6 || ringSize == 10);
+  Q_ASSERT(mask < (1u << ringSize));
+
+  offset = ((offset % ringSize) + ringSize) % ringSize;
+  const unsigned int fullMask = (1u << ringSize) - 1;
+  return ((mask << offset) | (mask >> (ringSize - offset))) & fullMask;
+}
+
+unsigned int LocalParticle::maskComponent(unsigned int mask,
+                                          unsigned int seeds, int ringSize) {
+  unsigned int component = seeds & mask;
+  unsigned int previous = 0;
+  while (component != previous) {
+    previous = component;
+    component |= (rotateMask(component, 1, ringSize) |
+                  rotateMask(component, -1, ringSize)) & mask;
+  }
+
+  return component;
+}
+
+int LocalParticle::firstLabelInMask(unsigned int mask, int startLabel,
+                                    int ringSize) {
+  Q_ASSERT(startLabel >= 0);
+
+  if (mask == 0) {
+    return -1;
+  }
+  startLabel %= ringSize;
+  const unsigned int rotated = rotateMask(mask, -startLabel, ringSize);
+  int offset = 0;
+  while (!(rotated >> offset & 1)) {
+    ++offset;
   }
 
-  return labels;
+  return (startLabel + offset) % ringSize;
 }
 
-const std::vector<int>& LocalParticle::headLabels() const {
+LabelSpan LocalParticle::headLabels() const {
   Q_ASSERT(-1 <= globalTailDir && globalTailDir < 6);
 
-  return isContracted() ? sixLabels : labels[tailDir()];
+  return isContracted() ? LabelSpan(sixLabels, 6)
+                        : LabelSpan(labels[tailDir()], 5);
 }
 
-const std::vector<int>& LocalParticle::tailLabels() const {
+LabelSpan LocalParticle::tailLabels() const {
   Q_ASSERT(isExpanded());
 
-  return labels[(tailDir() + 3) % 6];
+  return LabelSpan(labels[(tailDir() + 3) % 6], 5);
 }
 
 bool LocalParticle::isHeadLabel(int label) const {
   Q_ASSERT(0 <= label && label < 10);
 
-  for (const int headLabel : headLabels()) {
-    if (label == headLabel) {
-      return true;
-    }
-  }
-
-  return false;
+  return (headLabelMask() >> label) & 1;
 }
 
 bool LocalParticle::isTailLabel(int label) const {
   Q_ASSERT(isExpanded());
   Q_ASSERT(0 <= label && label < 10);
 
-  for (const int tailLabel : tailLabels()) {
-    if (label == tailLabel) {
-      return true;
-    }
-  }
-
-  return false;
+  return (tailLabelMask() >> label) & 1;
 }
 
 int LocalParticle::dirToHeadLabel(int dir) const {
   Q_ASSERT(0 <= dir && dir < 6);
 
-  for (const int headLabel : headLabels()) {
-    if (dir == labelToDir(headLabel)) {
-      return headLabel;
-    }
+  if (isContracted()) {
+    return dir;
   }
-
-  Q_ASSERT(false);
-  return 0;  // Avoid compiler warning.
+  const int headLabel = dirHeadLabel[tailDir()][dir];
+  Q_ASSERT(headLabel != -1);
+  return headLabel;
 }
 
 int LocalParticle::dirToTailLabel(int dir) const {
   Q_ASSERT(isExpanded());
   Q_ASSERT(0 <= dir && dir < 6);
 
-  for (const int tailLabel : tailLabels()) {
-    if (dir == labelToDir(tailLabel)) {
-      return tailLabel;
-    }
-  }
-
-  Q_ASSERT(false);
-  return 0;  // Avoid compiler warning.
+  const int tailLabel = dirTailLabel[tailDir()][dir];
+  Q_ASSERT(tailLabel != -1);
+  return tailLabel;
 }
 
 int LocalParticle::headContractionLabel() const {
@@ -155,50 +304,37 @@ int LocalParticle::tailContractionLabel() const {
   return contractLabels[(tailDir() + 3) % 6];
 }
 
-const std::vector<int>& LocalParticle::headLabelsAfterExpansion(
-    int expansionDir) const {
+LabelSpan LocalParticle::headLabelsAfterExpansion(int expansionDir) const {
   Q_ASSERT(isContracted());
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
   const int tempTailDir = (expansionDir + 3) % 6;
-  return labels[tempTailDir];
+  return LabelSpan(labels[tempTailDir], 5);
 }
 
-const std::vector<int>& LocalParticle::tailLabelsAfterExpansion(
-    int expansionDir) const {
+LabelSpan LocalParticle::tailLabelsAfterExpansion(int expansionDir) const {
   Q_ASSERT(isContracted());
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
-  const int tempTailDir = (expansionDir + 3) % 6;
-  return labels[(tempTailDir + 3) % 6];
+  return LabelSpan(labels[expansionDir], 5);
 }
 
 bool LocalParticle::isHeadLabelAfterExpansion(int label, int expansionDir)
     const {
   Q_ASSERT(isContracted());
+  Q_ASSERT(0 <= label && label < 10);
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
-  for (const int headLabel : headLabelsAfterExpansion(expansionDir)) {
-    if (label == headLabel) {
-      return true;
-    }
-  }
-
-  return false;
+  return (labelMasks[(expansionDir + 3) % 6] >> label) & 1;
 }
 
 bool LocalParticle::isTailLabelAfterExpansion(int label, int expansionDir)
     const {
   Q_ASSERT(isContracted());
+  Q_ASSERT(0 <= label && label < 10);
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
-  for (const int tailLabel : tailLabelsAfterExpansion(expansionDir)) {
-    if (label == tailLabel) {
-      return true;
-    }
-  }
-
-  return false;
+  return (labelMasks[expansionDir] >> label) & 1;
 }
 
 int LocalParticle::dirToHeadLabelAfterExpansion(int dir, int expansionDir)
@@ -207,14 +343,9 @@ int LocalParticle::dirToHeadLabelAfterExpansion(int dir, int expansionDir)
   Q_ASSERT(0 <= dir && dir < 6);
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
-  for (const int headLabel : headLabelsAfterExpansion(expansionDir)) {
-    if (dir == labelToDirAfterExpansion(headLabel, expansionDir)) {
-      return headLabel;
-    }
-  }
-
-  Q_ASSERT(false);
-  return 0;  // Avoid compiler warning.
+  const int headLabel = dirHeadLabel[(expansionDir + 3) % 6][dir];
+  Q_ASSERT(headLabel != -1);
+  return headLabel;
 }
 
 int LocalParticle::dirToTailLabelAfterExpansion(int dir, int expansionDir)
@@ -223,14 +354,9 @@ int LocalParticle::dirToTailLabelAfterExpansion(int dir, int expansionDir)
   Q_ASSERT(0 <= dir && dir < 6);
   Q_ASSERT(0 <= expansionDir && expansionDir < 6);
 
-  for (const int tailLabel : tailLabelsAfterExpansion(expansionDir)) {
-    if (dir == labelToDirAfterExpansion(tailLabel, expansionDir)) {
-      return tailLabel;
-    }
-  }
-
-  Q_ASSERT(false);
-  return 0;  // Avoid compiler warning.
+  const int tailLabel = dirTailLabel[(expansionDir + 3) % 6][dir];
+  Q_ASSERT(tailLabel != -1);
+  return tailLabel;
 }
 
 int LocalParticle::headContractionLabelAfterExpansion(int expansionDir) const {
@@ -26,11 +26,31 @@
 #define AMOEBOTSIM_CORE_LOCALPARTICLE_H_
 
 #include <array>
+#include <cstddef>
 #include <vector>
 
 #include "core/node.h"
 #include "core/particle.h"
 
+// A read-only list of labels backed by one of LocalParticle's constant label
+// tables. It can be iterated and indexed like the vector it replaces (and
+// converts to one where a copy is needed), but returning it never allocates.
+class LabelSpan {
+ public:
+  constexpr LabelSpan(const int* labels, std::size_t size)
+    : _labels(labels), _size(size) {}
+
+  const int* begin() const { return _labels; }
+  const int* end() const { return _labels + _size; }
+  std::size_t size() const { return _size; }
+  int operator[](std::size_t i) const { return _labels[i]; }
+  operator std::vector<int>() const { return {begin(), end()}; }
+
+ private:
+  const int* _labels;
+  std::size_t _size;
+};
+
 class LocalParticle : public Particle {
  public:
   // Constructs a new particle with a node position for its head, a global
@@ -50,10 +70,44 @@ class LocalParticle : public Particle {
   int labelToDirAfterExpansion(int label, int expansionDir) const;
 
   // Returns a list of labels which uniquely address the neighboring nodes.
-  const std::vector<int> uniqueLabels() const;
+  LabelSpan uniqueLabels() const;
+
+  // Functions for label masks, which represent sets of labels as bitmasks with
+  // bit i standing for label i. Labels form a ring of numLabels() labels (6 if
+  // contracted, 10 if expanded) ordered counter-clockwise, so the mask of a
+  // neighborhood can be tested, counted, and rotated with a few bit operations
+  // instead of loops over label vectors. labelMask returns the mask of labels
+  // satisfying the given predicate on labels. uniqueLabelMask returns the mask
+  // of uniqueLabels(), and headLabelMask (resp., tailLabelMask) the mask of
+  // headLabels() (resp., tailLabels()); all three are table lookups.
+  // labelsToMask converts a list of labels to a mask.
+  int numLabels() const;
+  template<class LabelCheck>
+  unsigned int labelMask(LabelCheck labelCheck) const;
+  unsigned int uniqueLabelMask() const;
+  unsigned int headLabelMask() const;
+  unsigned int tailLabelMask() const;
+  static unsigned int labelsToMask(const std::vector<int>& labels);
+  static unsigned int labelsToMask(LabelSpan labels);
+
+  // Helper functions over label masks on a ring of the given size (6 or 10).
+  // maskSize returns the number of labels in the mask. maskRuns returns the
+  // number of maximal runs of consecutive labels in the mask around the ring
+  // (e.g., 1 if the labels are connected); both are table lookups. rotateMask
+  // shifts every label in the mask by the given offset counter-clockwise.
+  // maskComponent returns the labels of the mask connected to any of the given
+  // seed labels through consecutive labels of the mask. firstLabelInMask
+  // returns the first label in the mask starting at the given label and
+  // continuing counter-clockwise, or -1 if the mask is empty.
+  static int maskSize(unsigned int mask);
+  static int maskRuns(unsigned int mask, int ringSize);
+  static unsigned int rotateMask(unsigned int mask, int offset, int ringSize);
+  static unsigned int maskComponent(unsigned int mask, unsigned int seeds,
+                                    int ringSize);
+  static int firstLabelInMask(unsigned int mask, int startLabel, int ringSize);
 
   // Functions for accessing labels specifically indicent to the head or tail.
-  // headLabels (respectively, tailLabels) returns a vector of labels of edges
+  // headLabels (respectively, tailLabels) returns a list of labels of edges
   // incident to the particle's head (respectively, tail). isHeadLabel (resp.,
   // isTailLabel) checks whether the given label is a head (resp., tail) label.
   // dirToHeadLabel (resp., dirToTailLabel) returns the head (resp., tail) label
@@ -63,8 +117,8 @@ class LocalParticle : public Particle {
   // the edge connecting the head and tail is not labelled. headContractionLabel
   // (resp., tailContractionLabel) returns the label needed to perform a head
   // (resp., tail) contraction.
-  const std::vector<int>& headLabels() const;
-  const std::vector<int>& tailLabels() const;
+  LabelSpan headLabels() const;
+  LabelSpan tailLabels() const;
   bool isHeadLabel(int label) const;
   bool isTailLabel(int label) const;
   int dirToHeadLabel(int dir) const;
@@ -74,8 +128,8 @@ class LocalParticle : public Particle {
 
   // Functions analogous to their non -AfterExpansion versions above, but return
   // values as if the particle first expanded in the given local direction.
-  const std::vector<int>& headLabelsAfterExpansion(int expansionDir) const;
-  const std::vector<int>& tailLabelsAfterExpansion(int expansionDir) const;
+  LabelSpan headLabelsAfterExpansion(int expansionDir) const;
+  LabelSpan tailLabelsAfterExpansion(int expansionDir) const;
   bool isHeadLabelAfterExpansion(int label, int expansionDir) const;
   bool isTailLabelAfterExpansion(int label, int expansionDir) const;
   int dirToHeadLabelAfterExpansion(int dir, int expansionDir) const;
@@ -123,10 +177,23 @@ class LocalParticle : public Particle {
   const int orientation;  // Offset from global direction for local compass.
 
  private:
-  static const std::vector<int> sixLabels;
-  static const std::array<const std::vector<int>, 6> labels;
-  static const std::array<int, 6> contractLabels;
-  static const std::array<std::array<int, 10>, 6> labelDir;
+  // The results of maskSize and maskRuns for every mask, indexed by mask.
+  static const std::array<unsigned char, 1024> maskSizes;
+  static const std::array<unsigned char, 64> maskRuns6;
+  static const std::array<unsigned char, 1024> maskRuns10;
 };
 
+template<class LabelCheck>
+unsigned int LocalParticle::labelMask(LabelCheck labelCheck) const {
+  unsigned int mask = 0;
+  const int labelLimit = numLabels();
+  for (int label = 0; label < labelLimit; ++label) {
+    if (labelCheck(label)) {
+      mask |= 1u << label;
+    }
+  }
+
+  return mask;
+}
+
 #endif  // AMOEBOTSIM_CORE_LOCALPARTICLE_H_
@@ -10,10 +10,6 @@ Count::Count(const QString name)
   : _name(name),
     _value(0) {}
 
-void Count::record(const unsigned int numEvents) {
-  _value += numEvents;
-}
-
 Measure::Measure(const QString name, const unsigned int freq)
   : _name(name),
     _freq(freq) {}
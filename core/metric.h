@@ -31,6 +31,27 @@ class Count {
   std::vector<int> _history;
 };
 
+class CountHandle {
+ public:
+  // Constructs a handle to the given count; a default-constructed handle refers
+  // to no count and must not be recorded through. Handles are obtained from
+  // AmoebotSystem::registerCount (or, once, from AmoebotSystem::countHandle)
+  // and stay valid for the lifetime of the system owning the count.
+  explicit CountHandle(Count* count = nullptr);
+
+  // Records the given number of events (default 1) on the referenced count.
+  // Unlike AmoebotSystem::getCount, this involves no lookup by name.
+  void record(const unsigned int numEvents = 1) const;
+
+  // Returns the referenced count. isValid checks whether this handle refers to
+  // a count at all.
+  Count& count() const;
+  bool isValid() const;
+
+ private:
+  Count* _count;
+};
+
 class Measure {
  public:
   // Constructs a new measure with a given name and calculation frequency.
@@ -52,4 +73,23 @@ class Measure {
   std::vector<double> _history;
 };
 
+inline void Count::record(const unsigned int numEvents) {
+  _value += numEvents;
+}
+
+inline CountHandle::CountHandle(Count* count)
+  : _count(count) {}
+
+inline void CountHandle::record(const unsigned int numEvents) const {
+  _count->record(numEvents);
+}
+
+inline Count& CountHandle::count() const {
+  return *_count;
+}
+
+inline bool CountHandle::isValid() const {
+  return _count != nullptr;
+}
+
 #endif  // AMOEBOTSIM_CORE_METRIC_H_
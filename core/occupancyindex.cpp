@@ -0,0 +1,110 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/occupancyindex.h"
+
+#include <algorithm>
+
+#include <QtGlobal>
+
+OccupancyIndex::OccupancyIndex()
+  : _originX(0),
+    _originY(0),
+    _width(0),
+    _height(0),
+    _releasesDeferred(false) {}
+
+OccupancyIndex::Chunk* OccupancyIndex::chunkForWrite(const Node& node) {
+  Chunk* chunk = chunkFor(node);
+  if (chunk != nullptr) {
+    return chunk;
+  }
+
+  const int chunkX = chunkCoord(node.x);
+  const int chunkY = chunkCoord(node.y);
+  if (chunkX < _originX || chunkX >= _originX + _width ||
+      chunkY < _originY || chunkY >= _originY + _height) {
+    growDirectory(chunkX, chunkY);
+  }
+
+  if (!_freeChunks.empty()) {
+    chunk = _freeChunks.back();
+    _freeChunks.pop_back();
+  } else {
+    _chunks.push_back(std::unique_ptr<Chunk>(new Chunk()));
+    chunk = _chunks.back().get();
+  }
+  _directory[(chunkY - _originY) * _width + (chunkX - _originX)] = chunk;
+
+  return chunk;
+}
+
+void OccupancyIndex::releaseChunk(const Node& node) {
+  const int dx = chunkCoord(node.x) - _originX;
+  const int dy = chunkCoord(node.y) - _originY;
+  Chunk*& entry = _directory[dy * _width + dx];
+  Q_ASSERT(entry != nullptr && entry->numOccupied == 0);
+
+  _freeChunks.push_back(entry);
+  entry = nullptr;
+}
+
+void OccupancyIndex::deferReleases() {
+  _releasesDeferred = true;
+}
+
+void OccupancyIndex::endDeferredReleases() {
+  _releasesDeferred = false;
+  for (auto& entry : _directory) {
+    if (entry != nullptr && entry->numOccupied == 0) {
+      _freeChunks.push_back(entry);
+      entry = nullptr;
+    }
+  }
+}
+
+void OccupancyIndex::growDirectory(int chunkX, int chunkY) {
+  int newOriginX, newOriginY, newWidth, newHeight;
+  if (_width == 0) {
+    // First allocation: start with a small window centered on the chunk.
+    newOriginX = chunkX - 2;
+    newOriginY = chunkY - 2;
+    newWidth = 5;
+    newHeight = 5;
+  } else {
+    // Extend each dimension that does not cover the chunk by at least its
+    // current extent on the side the chunk lies on.
+    newOriginX = _originX;
+    newOriginY = _originY;
+    newWidth = _width;
+    newHeight = _height;
+    if (chunkX < _originX) {
+      newOriginX = std::min(chunkX, _originX - _width);
+      newWidth += _originX - newOriginX;
+    } else if (chunkX >= _originX + _width) {
+      newWidth = std::max(chunkX - _originX + 1, 2 * _width);
+    }
+    if (chunkY < _originY) {
+      newOriginY = std::min(chunkY, _originY - _height);
+      newHeight += _originY - newOriginY;
+    } else if (chunkY >= _originY + _height) {
+      newHeight = std::max(chunkY - _originY + 1, 2 * _height);
+    }
+  }
+
+  std::vector<Chunk*> newDirectory(newWidth * newHeight, nullptr);
+  for (int y = 0; y < _height; ++y) {
+    for (int x = 0; x < _width; ++x) {
+      const int newX = x + _originX - newOriginX;
+      const int newY = y + _originY - newOriginY;
+      newDirectory[newY * newWidth + newX] = _directory[y * _width + x];
+    }
+  }
+
+  _directory.swap(newDirectory);
+  _originX = newOriginX;
+  _originY = newOriginY;
+  _width = newWidth;
+  _height = newHeight;
+}
@@ -0,0 +1,229 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a dense index over the triangular lattice recording which particle
+// and which object (if any) occupies each node. The lattice is partitioned into
+// fixed-size square chunks of nodes that are allocated on demand the first time
+// one of their nodes is written. A directory of chunk pointers covers the
+// bounding box of all allocated chunks, so a lookup is two array accesses and
+// never walks a tree. Nodes of a chunk are stored row by row (x fastest), so
+// the E/W neighbors of a node are adjacent in memory and all six neighbors of a
+// node usually live in the same chunk. Chunks whose cells all become empty are
+// detached from the directory and kept on a free list for reuse, so the index
+// follows the system's footprint instead of every node it has ever visited.
+// Besides occupancy, every node can carry a claim stamp, which
+// AmoebotSystem::activateInParallel uses to find activations that do not
+// interfere with each other.
+
+#ifndef AMOEBOTSIM_CORE_OCCUPANCYINDEX_H_
+#define AMOEBOTSIM_CORE_OCCUPANCYINDEX_H_
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "core/node.h"
+
+// AmoebotParticle and Object are only stored as pointers, so forward
+// declarations suffice and avoid a cyclic dependency with amoebotsystem.h.
+class AmoebotParticle;
+class Object;
+
+class OccupancyIndex {
+ public:
+  // The contents of a single lattice node. An expanded particle occupies two
+  // cells, one for its head and one for its tail, both pointing to it.
+  struct Cell {
+    AmoebotParticle* particle = nullptr;
+    Object* object = nullptr;
+  };
+
+  // Constructs an empty index; no chunks are allocated until the first write.
+  OccupancyIndex();
+
+  // Returns the particle (respectively, object) occupying the given node, or
+  // nullptr if the node is unoccupied.
+  AmoebotParticle* particleAt(const Node& node) const;
+  Object* objectAt(const Node& node) const;
+
+  // Records the given particle (respectively, object) as occupying the given
+  // node, allocating the node's chunk if necessary. Overwrites any particle
+  // (resp., object) previously recorded at that node.
+  void setParticle(const Node& node, AmoebotParticle* particle);
+  void setObject(const Node& node, Object* object);
+
+  // Marks the given node as no longer occupied by a particle (respectively, an
+  // object). Does nothing if the node's chunk was never allocated.
+  void clearParticle(const Node& node);
+  void clearObject(const Node& node);
+
+  // Returns the cell of the given node, or nullptr if its chunk has not been
+  // allocated (in which case the node is unoccupied).
+  const Cell* cellAt(const Node& node) const;
+
+  // Functions for claiming nodes. claim marks the given node with the given
+  // stamp, allocating the node's chunk if necessary, and isClaimed checks
+  // whether the node carries the given stamp. Stamps are never cleared; moving
+  // on to a new stamp releases all claims at once.
+  void claim(const Node& node, unsigned int stamp);
+  bool isClaimed(const Node& node, unsigned int stamp) const;
+
+  // Functions for letting particles move concurrently. While releases are
+  // deferred, chunks whose cells all become empty stay in the directory, so
+  // setting and clearing particles at nodes whose chunks exist never changes
+  // the directory; different threads may then write different nodes as long
+  // as no thread reads a node another one writes. Ending the deferral releases
+  // all chunks that are empty by then, including chunks only allocated for
+  // claims.
+  void deferReleases();
+  void endDeferredReleases();
+
+ private:
+  // Chunks are (1 << chunkBits) x (1 << chunkBits) nodes.
+  static constexpr int chunkBits = 5;
+  static constexpr int chunkSide = 1 << chunkBits;
+  static constexpr int chunkMask = chunkSide - 1;
+
+  // The occupied-cell count is atomic since concurrent writes to different
+  // nodes of a chunk (see deferReleases) all update it. Claims are kept apart
+  // from the cells so that they do not dilute the cells in the cache.
+  struct Chunk {
+    Cell cells[chunkSide * chunkSide];
+    unsigned int claims[chunkSide * chunkSide] = {};
+    std::atomic<int> numOccupied{0};  // # of cells holding a particle/object.
+  };
+
+  // Converts a node coordinate to the coordinate of its chunk. Uses an
+  // arithmetic shift so that negative coordinates round towards -infinity.
+  static int chunkCoord(int coord);
+
+  // Returns the index of the given node's cell within its chunk.
+  static int cellIndex(const Node& node);
+
+  // Returns the chunk containing the given node, or nullptr if it has not been
+  // allocated. chunkForWrite allocates the chunk (and grows the directory) if
+  // it does not exist yet.
+  Chunk* chunkFor(const Node& node) const;
+  Chunk* chunkForWrite(const Node& node);
+
+  // Rebuilds the directory so that it covers the given chunk coordinate. The
+  // directory grows geometrically to keep the amortized cost of growth O(1).
+  void growDirectory(int chunkX, int chunkY);
+
+  // Updates the occupied-cell count of the given node's chunk after one of the
+  // node's cell entries changed from wasOccupied to the cell's current state.
+  // A chunk left with no occupied cells is moved to the free list unless
+  // releases are deferred; since all of its cells are then empty, it can be
+  // handed out again without clearing.
+  void updateOccupancy(Chunk* chunk, const Node& node, bool wasOccupied);
+  void releaseChunk(const Node& node);
+
+  static bool isOccupied(const Cell& cell);
+
+  std::vector<std::unique_ptr<Chunk>> _chunks;
+  std::vector<Chunk*> _freeChunks;
+  std::vector<Chunk*> _directory;
+  int _originX, _originY;   // Chunk coordinate of the directory's first entry.
+  int _width, _height;      // Directory extent in chunks.
+  bool _releasesDeferred;
+};
+
+inline int OccupancyIndex::chunkCoord(int coord) {
+  return coord >> chunkBits;
+}
+
+inline int OccupancyIndex::cellIndex(const Node& node) {
+  return ((node.y & chunkMask) << chunkBits) | (node.x & chunkMask);
+}
+
+inline OccupancyIndex::Chunk* OccupancyIndex::chunkFor(const Node& node) const {
+  const unsigned int dx = chunkCoord(node.x) - _originX;
+  const unsigned int dy = chunkCoord(node.y) - _originY;
+  if (dx >= static_cast<unsigned int>(_width) ||
+      dy >= static_cast<unsigned int>(_height)) {
+    return nullptr;
+  }
+
+  return _directory[dy * _width + dx];
+}
+
+inline bool OccupancyIndex::isOccupied(const Cell& cell) {
+  return cell.particle != nullptr || cell.object != nullptr;
+}
+
+inline void OccupancyIndex::updateOccupancy(Chunk* chunk, const Node& node,
+                                            bool wasOccupied) {
+  const bool occupied = isOccupied(chunk->cells[cellIndex(node)]);
+  if (occupied && !wasOccupied) {
+    ++chunk->numOccupied;
+  } else if (!occupied && wasOccupied && --chunk->numOccupied == 0 &&
+             !_releasesDeferred) {
+    releaseChunk(node);
+  }
+}
+
+inline const OccupancyIndex::Cell* OccupancyIndex::cellAt(const Node& node)
+    const {
+  const Chunk* chunk = chunkFor(node);
+  return (chunk == nullptr) ? nullptr : &chunk->cells[cellIndex(node)];
+}
+
+inline AmoebotParticle* OccupancyIndex::particleAt(const Node& node) const {
+  const Cell* cell = cellAt(node);
+  return (cell == nullptr) ? nullptr : cell->particle;
+}
+
+inline Object* OccupancyIndex::objectAt(const Node& node) const {
+  const Cell* cell = cellAt(node);
+  return (cell == nullptr) ? nullptr : cell->object;
+}
+
+inline void OccupancyIndex::setParticle(const Node& node,
+                                        AmoebotParticle* particle) {
+  Chunk* chunk = chunkForWrite(node);
+  Cell& cell = chunk->cells[cellIndex(node)];
+  const bool wasOccupied = isOccupied(cell);
+  cell.particle = particle;
+  updateOccupancy(chunk, node, wasOccupied);
+}
+
+inline void OccupancyIndex::setObject(const Node& node, Object* object) {
+  Chunk* chunk = chunkForWrite(node);
+  Cell& cell = chunk->cells[cellIndex(node)];
+  const bool wasOccupied = isOccupied(cell);
+  cell.object = object;
+  updateOccupancy(chunk, node, wasOccupied);
+}
+
+inline void OccupancyIndex::clearParticle(const Node& node) {
+  Chunk* chunk = chunkFor(node);
+  if (chunk != nullptr) {
+    Cell& cell = chunk->cells[cellIndex(node)];
+    const bool wasOccupied = isOccupied(cell);
+    cell.particle = nullptr;
+    updateOccupancy(chunk, node, wasOccupied);
+  }
+}
+
+inline void OccupancyIndex::claim(const Node& node, unsigned int stamp) {
+  chunkForWrite(node)->claims[cellIndex(node)] = stamp;
+}
+
+inline bool OccupancyIndex::isClaimed(const Node& node, unsigned int stamp)
+    const {
+  const Chunk* chunk = chunkFor(node);
+  return chunk != nullptr && chunk->claims[cellIndex(node)] == stamp;
+}
+
+inline void OccupancyIndex::clearObject(const Node& node) {
+  Chunk* chunk = chunkFor(node);
+  if (chunk != nullptr) {
+    Cell& cell = chunk->cells[cellIndex(node)];
+    const bool wasOccupied = isOccupied(cell);
+    cell.object = nullptr;
+    updateOccupancy(chunk, node, wasOccupied);
+  }
+}
+
+#endif  // AMOEBOTSIM_CORE_OCCUPANCYINDEX_H_
@@ -57,6 +57,18 @@ std::array<int, 6> Particle::borderPointColors() const {
   return borderPointColors;
 }
 
+Appearance Particle::appearance() const {
+  Appearance appearance;
+  appearance.headMarkColor = headMarkColor();
+  appearance.headMarkDir = headMarkGlobalDir();
+  appearance.tailMarkColor = tailMarkColor();
+  appearance.tailMarkDir = tailMarkGlobalDir();
+  appearance.borderColors = borderColors();
+  appearance.borderPointColors = borderPointColors();
+
+  return appearance;
+}
+
 QString Particle::inspectionText() const {
   return "Overwrite Particle::inspectionText() to specify an inspection text.";
 }
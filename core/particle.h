@@ -14,6 +14,17 @@
 
 #include "core/node.h"
 
+// The cosmetic appearance of a particle, i.e., the values of all of its
+// appearance functions (see Particle) captured in a single record.
+struct Appearance {
+  int headMarkColor = -1;
+  int headMarkDir = -1;
+  int tailMarkColor = -1;
+  int tailMarkDir = -1;
+  std::array<int, 18> borderColors;
+  std::array<int, 6> borderPointColors;
+};
+
 class Particle {
  public:
   // Constructs a new particle with a node position for its head and a global
@@ -48,6 +59,11 @@ class Particle {
   virtual std::array<int, 18> borderColors() const;
   virtual std::array<int, 6> borderPointColors() const;
 
+  // Returns the particle's current appearance, calling each of the functions
+  // above exactly once. Systems cache the result (see System::appearanceAt),
+  // so drawing a particle does not call them every frame.
+  Appearance appearance() const;
+
   // Returns the string to be displayed when this particle is inspected; used
   // to snapshot the current values of this particle's memory at runtime.
   virtual QString inspectionText() const;
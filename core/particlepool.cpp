@@ -0,0 +1,155 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/particlepool.h"
+
+#include <mutex>
+#include <new>
+
+#include <QtGlobal>
+
+thread_local ParticlePool* ParticlePool::boundPool = nullptr;
+
+namespace {
+
+// Slabs released by destroyed pools, kept for the next pool on any thread.
+struct SlabCache {
+  ~SlabCache() {
+    for (auto slab : slabs) {
+      ::operator delete(slab);
+    }
+  }
+
+  std::mutex mutex;
+  std::vector<char*> slabs;
+};
+
+SlabCache& slabCache() {
+  static SlabCache cache;
+  return cache;
+}
+
+}  // namespace
+
+ParticlePool::ParticlePool()
+  : _tearingDown(false) {}
+
+ParticlePool::~ParticlePool() {
+  if (boundPool == this) {
+    boundPool = nullptr;
+  }
+
+  SlabCache& cache = slabCache();
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    while (!_slabs.empty() && cache.slabs.size() < maxCachedSlabs) {
+      cache.slabs.push_back(_slabs.back());
+      _slabs.pop_back();
+    }
+  }
+  for (auto slab : _slabs) {
+    ::operator delete(slab);
+  }
+  for (auto slab : _oversizedSlabs) {
+    ::operator delete(slab);
+  }
+}
+
+ParticlePool* ParticlePool::bind(ParticlePool* pool) {
+  ParticlePool* previous = boundPool;
+  boundPool = pool;
+  return previous;
+}
+
+void* ParticlePool::allocate(std::size_t size) {
+  if (boundPool != nullptr) {
+    return boundPool->allocateBlock(size);
+  }
+
+  Header* header =
+      static_cast<Header*>(::operator new(sizeof(Header) + size));
+  header->pool = nullptr;
+  header->sizeClass = 0;
+  return header + 1;
+}
+
+void ParticlePool::deallocate(void* ptr) {
+  if (ptr == nullptr) {
+    return;
+  }
+
+  Header* header = static_cast<Header*>(ptr) - 1;
+  if (header->pool == nullptr) {
+    ::operator delete(header);
+  } else if (!header->pool->_tearingDown) {
+    header->pool->_sizeClasses[header->sizeClass].freeBlocks.push_back(header);
+  }
+}
+
+void ParticlePool::beginTeardown() {
+  _tearingDown = true;
+}
+
+void* ParticlePool::allocateBlock(std::size_t size) {
+  const std::size_t align = alignof(std::max_align_t);
+  const std::size_t blockSize =
+      sizeof(Header) + (size + align - 1) / align * align;
+
+  // A system rarely has more than a handful of particle types, so a linear
+  // search over the size classes is cheaper than any map.
+  std::size_t index = 0;
+  while (index < _sizeClasses.size() &&
+         _sizeClasses[index].blockSize != blockSize) {
+    ++index;
+  }
+  if (index == _sizeClasses.size()) {
+    _sizeClasses.push_back({blockSize, nullptr, nullptr, {}});
+  }
+  SizeClass& sizeClass = _sizeClasses[index];
+
+  Header* header;
+  if (!sizeClass.freeBlocks.empty()) {
+    header = sizeClass.freeBlocks.back();
+    sizeClass.freeBlocks.pop_back();
+  } else {
+    if (sizeClass.next == sizeClass.end) {
+      refill(sizeClass);
+    }
+    header = reinterpret_cast<Header*>(sizeClass.next);
+    sizeClass.next += blockSize;
+  }
+  header->pool = this;
+  header->sizeClass = index;
+
+  return header + 1;
+}
+
+void ParticlePool::refill(SizeClass& sizeClass) {
+  char* slab;
+  std::size_t numBlocks;
+  if (sizeClass.blockSize > slabSize) {
+    slab = static_cast<char*>(::operator new(sizeClass.blockSize));
+    numBlocks = 1;
+    _oversizedSlabs.push_back(slab);
+  } else {
+    SlabCache& cache = slabCache();
+    slab = nullptr;
+    {
+      std::lock_guard<std::mutex> lock(cache.mutex);
+      if (!cache.slabs.empty()) {
+        slab = cache.slabs.back();
+        cache.slabs.pop_back();
+      }
+    }
+    if (slab == nullptr) {
+      slab = static_cast<char*>(::operator new(slabSize));
+    }
+    numBlocks = slabSize / sizeClass.blockSize;
+    _slabs.push_back(slab);
+  }
+
+  Q_ASSERT(numBlocks > 0);
+  sizeClass.next = slab;
+  sizeClass.end = slab + numBlocks * sizeClass.blockSize;
+}
@@ -0,0 +1,88 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the memory pool particles are allocated from. Each AmoebotSystem owns
+// a pool and binds it to the calling thread while it is constructed or
+// activated, just like its random number engine; AmoebotParticle's operator new
+// then carves particles out of the bound pool instead of the global heap.
+// Blocks are grouped by size, which in practice means by particle type, and cut
+// from contiguous slabs, so particles of a system sit next to each other in
+// memory. Deleted particles return their block to a per-size free list for
+// reuse, and all slabs are released in bulk when the pool is destroyed. Released
+// slabs are kept in a cache shared by all threads and handed to the next pool
+// that needs one, so repeatedly instantiating systems (e.g., from scripts or
+// replicas) does not go back to the heap, even though systems are usually
+// destroyed on a different thread than the one running them.
+
+#ifndef AMOEBOTSIM_CORE_PARTICLEPOOL_H_
+#define AMOEBOTSIM_CORE_PARTICLEPOOL_H_
+
+#include <cstddef>
+#include <vector>
+
+class ParticlePool {
+ public:
+  // Constructs an empty pool; no slabs are taken until the first allocation.
+  ParticlePool();
+
+  // Releases all slabs of this pool to the shared slab cache. All particles
+  // allocated from this pool must have been deleted before.
+  ~ParticlePool();
+
+  ParticlePool(const ParticlePool&) = delete;
+  ParticlePool& operator=(const ParticlePool&) = delete;
+
+  // Binds the given pool to the calling thread, so that subsequent particle
+  // allocations on this thread use it; nullptr unbinds the current pool.
+  // Returns the previously bound pool.
+  static ParticlePool* bind(ParticlePool* pool);
+
+  // Allocates (resp., deallocates) memory for a particle of the given size.
+  // allocate uses the pool bound to the calling thread, or the global heap if
+  // there is none. deallocate returns the memory to wherever it came from,
+  // regardless of which pool is currently bound.
+  static void* allocate(std::size_t size);
+  static void deallocate(void* ptr);
+
+  // Makes deallocate a no-op for blocks of this pool, whose memory is released
+  // with the slabs anyway. Call this before deleting all particles right before
+  // destroying the pool, so their blocks are not pushed onto the free lists.
+  void beginTeardown();
+
+ private:
+  // Every block starts with a header recording the pool that owns it (nullptr
+  // for heap blocks) and its size class, so deallocate needs no lookup. The
+  // header is padded to the maximum alignment to keep particles aligned.
+  struct alignas(alignof(std::max_align_t)) Header {
+    ParticlePool* pool;
+    std::size_t sizeClass;
+  };
+
+  // Blocks of one size, cut in order from the current slab and recycled
+  // through a free list.
+  struct SizeClass {
+    std::size_t blockSize;
+    char* next;
+    char* end;
+    std::vector<Header*> freeBlocks;
+  };
+
+  // Slabs have a fixed size so that they can be cached and reused by pools
+  // serving particles of other sizes; only particles larger than a slab get a
+  // dedicated slab, which is not cached.
+  static const std::size_t slabSize = 64 * 1024;
+  static const std::size_t maxCachedSlabs = 1024;
+
+  void* allocateBlock(std::size_t size);
+  void refill(SizeClass& sizeClass);
+
+  std::vector<SizeClass> _sizeClasses;
+  std::vector<char*> _slabs;
+  std::vector<char*> _oversizedSlabs;
+  bool _tearingDown;
+
+  static thread_local ParticlePool* boundPool;
+};
+
+#endif  // AMOEBOTSIM_CORE_PARTICLEPOOL_H_
@@ -0,0 +1,127 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/rendersnapshot.h"
+
+#include <algorithm>
+
+#include "core/object.h"
+
+ParticleSnapshot::ParticleSnapshot(const Particle& particle,
+                                   const Appearance& appearance)
+  : Appearance(appearance),
+    head(particle.head),
+    globalTailDir(particle.globalTailDir) {}
+
+RenderSnapshotBuffer::RenderSnapshotBuffer()
+  : _resetSincePublish(true),
+    _version(0),
+    _back(0),
+    _ready(1),
+    _front(2) {}
+
+void RenderSnapshotBuffer::reset() {
+  for (Pending& pending : _pending) {
+    pending.rebuild = true;
+    pending.indices.clear();
+    pending.isPending.clear();
+  }
+  _resetSincePublish = true;
+}
+
+void RenderSnapshotBuffer::publish(System* system) {
+  RenderSnapshot& snapshot = _snapshots[_back];
+  Pending& back = _pending[_back];
+
+  // If the renderer has acquired the last published snapshot, it has seen all
+  // changes so far. Otherwise, it may still acquire the last snapshot while
+  // this one is written, in which case it is merely told about some changes
+  // twice.
+  if (!(_ready.load(std::memory_order_acquire) & freshBit)) {
+    for (const int i : _unacquired.indices) {
+      _unacquired.isPending[i] = false;
+    }
+    _unacquired.indices.clear();
+    _unacquired.rebuild = false;
+  }
+  if (_resetSincePublish || system == nullptr) {
+    _unacquired.rebuild = true;
+    _resetSincePublish = false;
+  }
+
+  if (system == nullptr) {
+    snapshot.particles.clear();
+    snapshot.objects.clear();
+    back.rebuild = true;
+  } else {
+    // Record the system's changes for all three snapshots, since the other two
+    // will miss them until they become the back snapshot again, and for the
+    // renderer.
+    _changed.clear();
+    system->takeChangedParticles(_changed);
+    for (Pending& pending : _pending) {
+      if (!pending.rebuild) {
+        addPending(pending, _changed);
+      }
+    }
+    if (!_unacquired.rebuild) {
+      addPending(_unacquired, _changed);
+    }
+
+    const int size = system->size();
+    snapshot.particles.resize(size);
+    if (back.rebuild) {
+      for (int i = 0; i < size; ++i) {
+        snapshot.particles[i] =
+            ParticleSnapshot(system->at(i), system->appearanceAt(i));
+      }
+      snapshot.objects.clear();
+      back.rebuild = false;
+    } else {
+      for (const int i : back.indices) {
+        back.isPending[i] = false;
+        if (i < size) {
+          snapshot.particles[i] =
+              ParticleSnapshot(system->at(i), system->appearanceAt(i));
+        }
+      }
+    }
+    back.indices.clear();
+
+    // Objects never move and are only ever appended, so only new objects need
+    // to be copied.
+    const auto& objects = system->getObjects();
+    for (size_t i = snapshot.objects.size(); i < objects.size(); ++i) {
+      snapshot.objects.push_back(objects[i]->_node);
+    }
+  }
+
+  snapshot.version = ++_version;
+  snapshot.changed = _unacquired.indices;
+  snapshot.allChanged = _unacquired.rebuild;
+
+  _back = _ready.exchange(_back | freshBit, std::memory_order_acq_rel) &
+          ~freshBit;
+}
+
+void RenderSnapshotBuffer::addPending(Pending& pending,
+                                      const std::vector<int>& indices) {
+  for (const int i : indices) {
+    if (i >= static_cast<int>(pending.isPending.size())) {
+      pending.isPending.resize(
+          std::max<size_t>(i + 1, 2 * pending.isPending.size()));
+    }
+    if (!pending.isPending[i]) {
+      pending.isPending[i] = true;
+      pending.indices.push_back(i);
+    }
+  }
+}
+
+const RenderSnapshot& RenderSnapshotBuffer::acquire() {
+  if (_ready.load(std::memory_order_acquire) & freshBit) {
+    _front = _ready.exchange(_front, std::memory_order_acq_rel) & ~freshBit;
+  }
+  return _snapshots[_front];
+}
@@ -0,0 +1,103 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the snapshots of a particle system that the simulator publishes for
+// the renderer. A snapshot is a compact copy of everything VisItem draws: the
+// particles' positions and appearance and the objects' positions. A
+// RenderSnapshotBuffer holds three snapshots (triple buffering). The simulator
+// writes the back snapshot while it holds the system's mutex and then swaps it
+// with the ready one; the renderer swaps the ready snapshot with the one it
+// reads whenever a newer one is ready. Neither side ever waits for the other,
+// and the renderer never takes the system's mutex. Each snapshot is brought up
+// to date by copying only the particles that changed since it was last written
+// (see System::takeChangedParticles), so publishing a snapshot costs time
+// proportional to the number of changed particles, not to the system's size.
+// Likewise, every snapshot lists the particles that changed since the snapshot
+// the renderer held when it was published, so that a renderer keeping its own
+// copy of the particles (see ParticleRenderer) only needs to update those.
+
+#ifndef AMOEBOTSIM_CORE_RENDERSNAPSHOT_H_
+#define AMOEBOTSIM_CORE_RENDERSNAPSHOT_H_
+
+#include <atomic>
+#include <vector>
+
+#include "core/node.h"
+#include "core/particle.h"
+#include "core/system.h"
+
+// The position and appearance of a single particle.
+struct ParticleSnapshot : public Appearance {
+  ParticleSnapshot() = default;
+  ParticleSnapshot(const Particle& particle, const Appearance& appearance);
+
+  Node head;
+  int globalTailDir = -1;
+};
+
+struct RenderSnapshot {
+  std::vector<ParticleSnapshot> particles;  // Indexed like the particle list.
+  std::vector<Node> objects;
+
+  // The number of snapshots published up to this one, and the indices of the
+  // particles that changed since the snapshot the renderer had acquired when
+  // this one was published (or all particles if allChanged is true). Indices
+  // may be out of range if particles have been removed since.
+  unsigned long long version = 0;
+  std::vector<int> changed;
+  bool allChanged = true;
+};
+
+class RenderSnapshotBuffer {
+ public:
+  // Constructs a buffer of three empty snapshots.
+  RenderSnapshotBuffer();
+
+  RenderSnapshotBuffer(const RenderSnapshotBuffer&) = delete;
+  RenderSnapshotBuffer& operator=(const RenderSnapshotBuffer&) = delete;
+
+  // Functions for the simulator's thread. reset makes every snapshot start
+  // over from scratch the next time it is written; it must be called whenever
+  // the simulated system is replaced. publish brings the back snapshot up to
+  // date with the given system (or empties it if the system is nullptr) and
+  // makes it the ready snapshot. The caller must hold the system's mutex.
+  void reset();
+  void publish(System* system);
+
+  // Returns the most recently published snapshot. For the renderer's thread
+  // only; the snapshot remains valid and unchanged until the next call.
+  const RenderSnapshot& acquire();
+
+ private:
+  // The changes a snapshot has missed since it was last written, kept by the
+  // simulator's thread for each of the three snapshots.
+  struct Pending {
+    bool rebuild = true;
+    std::vector<int> indices;
+    std::vector<bool> isPending;
+  };
+
+  // Adds the given indices to the given changes, each at most once.
+  static void addPending(Pending& pending, const std::vector<int>& indices);
+
+  // The slot index stored in _ready is tagged with freshBit if the renderer
+  // has not acquired it yet.
+  static const int freshBit = 4;
+
+  RenderSnapshot _snapshots[3];
+  Pending _pending[3];
+  std::vector<int> _changed;
+
+  // The changes published since the last snapshot the renderer is known to
+  // have acquired, listed in the snapshots' changed indices.
+  Pending _unacquired;
+  bool _resetSincePublish;
+  unsigned long long _version;
+
+  int _back;               // Owned by the simulator's thread.
+  std::atomic<int> _ready;
+  int _front;              // Owned by the renderer's thread.
+};
+
+#endif  // AMOEBOTSIM_CORE_RENDERSNAPSHOT_H_
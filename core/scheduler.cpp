@@ -0,0 +1,114 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/scheduler.h"
+
+#include <numeric>
+#include <utility>
+
+#include <QtGlobal>
+
+const Scheduler::Policy Scheduler::policies[4] = {
+  Policy::Uniform, Policy::Permutation, Policy::RoundRobin, Policy::Adversarial
+};
+
+std::unique_ptr<Scheduler> Scheduler::create(const Policy policy,
+                                             const uint32_t seed) {
+  switch (policy) {
+    case Policy::Uniform:
+      return std::unique_ptr<Scheduler>(new UniformScheduler());
+    case Policy::Permutation:
+      return std::unique_ptr<Scheduler>(new PermutationScheduler());
+    case Policy::RoundRobin:
+      return std::unique_ptr<Scheduler>(new RoundRobinScheduler());
+    case Policy::Adversarial:
+      return std::unique_ptr<Scheduler>(new AdversarialScheduler(seed));
+  }
+  Q_ASSERT(false);  // Unknown policy.
+  return nullptr;
+}
+
+const char* Scheduler::name(const Policy policy) {
+  switch (policy) {
+    case Policy::Uniform:     return "uniform";
+    case Policy::Permutation: return "permutation";
+    case Policy::RoundRobin:  return "roundrobin";
+    case Policy::Adversarial: return "adversarial";
+  }
+  return "";
+}
+
+Scheduler::Policy UniformScheduler::policy() const {
+  return Policy::Uniform;
+}
+
+int UniformScheduler::next(const int numParticles) {
+  return randInt(0, numParticles);
+}
+
+PermutationScheduler::PermutationScheduler()
+  : _pos(0) {}
+
+Scheduler::Policy PermutationScheduler::policy() const {
+  return Policy::Permutation;
+}
+
+int PermutationScheduler::next(const int numParticles) {
+  if (static_cast<int>(_order.size()) != numParticles) {
+    _order.resize(numParticles);
+    std::iota(_order.begin(), _order.end(), 0);
+    _pos = 0;
+  } else if (_pos == numParticles) {
+    _pos = 0;
+  }
+
+  std::swap(_order[_pos], _order[randInt(_pos, numParticles)]);
+  return _order[_pos++];
+}
+
+RoundRobinScheduler::RoundRobinScheduler()
+  : _next(0) {}
+
+Scheduler::Policy RoundRobinScheduler::policy() const {
+  return Policy::RoundRobin;
+}
+
+int RoundRobinScheduler::next(const int numParticles) {
+  if (_next >= numParticles) {
+    _next = 0;
+  }
+  return _next++;
+}
+
+AdversarialScheduler::AdversarialScheduler(const uint32_t seed)
+  : _engine(seed, Engine::Kind::Xoshiro256StarStar),
+    _pos(0),
+    _current(0),
+    _burstLeft(0) {}
+
+Scheduler::Policy AdversarialScheduler::policy() const {
+  return Policy::Adversarial;
+}
+
+int AdversarialScheduler::next(const int numParticles) {
+  if (static_cast<int>(_order.size()) != numParticles) {
+    _order.resize(numParticles);
+    std::iota(_order.begin(), _order.end(), 0);
+    _pos = 0;
+    _burstLeft = 0;
+  }
+
+  if (_burstLeft == 0) {
+    if (_pos == numParticles) {
+      _pos = 0;
+    }
+    const int swapPos = _pos + _engine.bounded(numParticles - _pos);
+    std::swap(_order[_pos], _order[swapPos]);
+    _current = _order[_pos++];
+    _burstLeft = 1 + _engine.bounded(maxBurst);
+  }
+
+  --_burstLeft;
+  return _current;
+}
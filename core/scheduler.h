@@ -0,0 +1,108 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the schedulers deciding which particle AmoebotSystem::activate
+// activates next. Every scheduler picks the next particle in constant time. The
+// policies are:
+//   - Uniform: a particle drawn uniformly at random, as the amoebot model's
+//     sequential scheduler does (the default). A round then takes about
+//     n * H(n) activations, where n is the number of particles.
+//   - Permutation: the particles in a fresh random order every n activations,
+//     so that every round takes exactly n activations.
+//   - RoundRobin: the particles in the order of the system's particle list.
+//   - Adversarial: the particles in a fresh order every round, each activated
+//     between 1 and maxBurst times in a row. Its choices come from its own
+//     engine seeded with the seed it is created with, so an adversary can be
+//     replayed against different seeds of the system.
+// Uniform and Permutation draw from the engine bound to the calling thread,
+// i.e., the system's engine. Schedulers refer to particles by their index in
+// the particle list; whenever the number of particles changes, the orders of
+// Permutation and Adversarial start over.
+
+#ifndef AMOEBOTSIM_CORE_SCHEDULER_H_
+#define AMOEBOTSIM_CORE_SCHEDULER_H_
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "helper/randomnumbergenerator.h"
+
+class Scheduler : public RandomNumberGenerator {
+ public:
+  enum class Policy { Uniform, Permutation, RoundRobin, Adversarial };
+
+  // The policies in the order of their declaration, for iterating over them.
+  static const Policy policies[4];
+
+  // Creates a scheduler of the given policy. The seed is only used by
+  // Policy::Adversarial.
+  static std::unique_ptr<Scheduler> create(const Policy policy,
+                                           const uint32_t seed = 0);
+
+  // Returns the name of the given policy ("uniform", "permutation",
+  // "roundrobin", or "adversarial").
+  static const char* name(const Policy policy);
+
+  virtual ~Scheduler() = default;
+
+  // Returns the policy of this scheduler.
+  virtual Policy policy() const = 0;
+
+  // Returns the index of the particle to activate next in a system of the
+  // given (positive) number of particles.
+  virtual int next(const int numParticles) = 0;
+};
+
+class UniformScheduler : public Scheduler {
+ public:
+  Policy policy() const override;
+  int next(const int numParticles) override;
+};
+
+class PermutationScheduler : public Scheduler {
+ public:
+  PermutationScheduler();
+
+  Policy policy() const override;
+  int next(const int numParticles) override;
+
+ private:
+  // The current order. The first _pos entries have been activated this round;
+  // the next entry is drawn from the remaining ones, which shuffles the order
+  // one step at a time (Fisher-Yates).
+  std::vector<int> _order;
+  int _pos;
+};
+
+class RoundRobinScheduler : public Scheduler {
+ public:
+  RoundRobinScheduler();
+
+  Policy policy() const override;
+  int next(const int numParticles) override;
+
+ private:
+  int _next;
+};
+
+class AdversarialScheduler : public Scheduler {
+ public:
+  // The largest number of activations of a particle in a row.
+  static const int maxBurst = 4;
+
+  explicit AdversarialScheduler(const uint32_t seed);
+
+  Policy policy() const override;
+  int next(const int numParticles) override;
+
+ private:
+  Engine _engine;
+  std::vector<int> _order;  // As for PermutationScheduler.
+  int _pos;
+  int _current;
+  int _burstLeft;           // # of activations of _current still to come.
+};
+
+#endif  // AMOEBOTSIM_CORE_SCHEDULER_H_
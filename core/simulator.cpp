@@ -4,6 +4,9 @@
 
 #include "core/simulator.h"
 
+#include <algorithm>
+#include <thread>
+
 #include <QCoreApplication>
 #include <QDateTime>
 #include <QDir>
@@ -14,9 +17,20 @@
 
 #include "core/metric.h"
 
-Simulator::Simulator() {
+Simulator::Simulator()
+  : stepTimer(this),
+    mode(Mode::Sequential),
+    numThreads(1),
+    schedulerPolicy(Scheduler::Policy::Uniform),
+    schedulerSeed(0),
+    batchSize(1),
+    adaptiveBatchSize(1),
+    frameBudget(16),
+    cancelRequested(false),
+    shutDown(false),
+    snapshots(std::make_shared<RenderSnapshotBuffer>()) {
   stepTimer.setInterval(100);
-  connect(&stepTimer, &QTimer::timeout, this, &Simulator::step);
+  connect(&stepTimer, &QTimer::timeout, this, &Simulator::stepBatch);
 }
 
 Simulator::~Simulator() {
@@ -28,6 +42,15 @@ void Simulator::setSystem(std::shared_ptr<System> _system) {
   emit stopped();
 
   system = _system;
+  adaptiveBatchSize = 1;
+  snapshots->reset();
+  if (system != nullptr) {
+    QMutexLocker locker(&system->mutex);
+    system->setScheduler(schedulerPolicy, schedulerSeed);
+    publish(true);
+  } else {
+    snapshots->publish(nullptr);
+  }
   emit systemChanged(system);
 }
 
@@ -35,21 +58,47 @@ std::shared_ptr<System> Simulator::getSystem() const {
   return system;
 }
 
+std::shared_ptr<RenderSnapshotBuffer> Simulator::renderSnapshots() const {
+  return snapshots;
+}
+
 void Simulator::start() {
+  cancelRequested = false;
   stepTimer.start();
   emit started();
 }
 
 void Simulator::stop() {
   stepTimer.stop();
+  cancelRequested = false;
   emit stopped();
 }
 
+void Simulator::cancel() {
+  cancelRequested = true;
+  QMetaObject::invokeMethod(this, "stop", Qt::QueuedConnection);
+}
+
+void Simulator::clearCancel() {
+  cancelRequested = false;
+}
+
+void Simulator::shutdown() {
+  shutDown = true;
+  cancel();
+}
+
+bool Simulator::isCancelled() const {
+  return cancelRequested || shutDown;
+}
+
 void Simulator::step() {
   QMutexLocker locker(&system->mutex);
-  system->activate();
+  advance();
+  publish(true);
 
-  if (system->hasTerminated()) {
+  if (system->checkTermination()) {
+    locker.unlock();
     stop();
   }
 }
@@ -57,6 +106,7 @@ void Simulator::step() {
 void Simulator::stepForParticleAt(Node node) {
   QMutexLocker locker(&system->mutex);
   system->activateParticleAt(node);
+  publish(true);
 }
 
 void Simulator::setStepDuration(int ms) {
@@ -65,12 +115,96 @@ void Simulator::setStepDuration(int ms) {
 }
 
 void Simulator::runUntilTermination() {
-  QMutexLocker locker(&system->mutex);
-  while (!system->hasTerminated()) {
+  // Advance in chunks of about one frame budget, releasing the system's mutex
+  // in between so that the system can be drawn. Reading the clock after every
+  // step would dominate short activations, so it is only read every
+  // clockCheckInterval steps.
+  const unsigned int clockCheckInterval = 64;
+  QElapsedTimer timer;
+  bool terminated = false;
+  while (!terminated && !isCancelled()) {
+    QMutexLocker locker(&system->mutex);
+    timer.start();
+    for (unsigned int i = 1; !isCancelled(); ++i) {
+      terminated = system->checkTermination();
+      if (terminated || (i % clockCheckInterval == 0 &&
+                         timer.elapsed() >= frameBudget)) {
+        break;
+      }
+      advance();
+    }
+    publish(terminated || isCancelled());
+  }
+}
+
+void Simulator::setMode(Mode mode, int numThreads) {
+  this->mode = mode;
+  adaptiveBatchSize = 1;
+  if (numThreads > 0) {
+    this->numThreads = numThreads;
+  } else {
+    this->numThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+void Simulator::setScheduler(Scheduler::Policy policy, uint32_t seed) {
+  schedulerPolicy = policy;
+  schedulerSeed = seed;
+  if (system != nullptr) {
+    QMutexLocker locker(&system->mutex);
+    system->setScheduler(policy, seed);
+  }
+}
+
+void Simulator::setBatchSize(int size) {
+  batchSize = std::max(0, size);
+  emit batchSizeChanged(batchSize);
+}
+
+void Simulator::setFrameBudget(int ms) {
+  frameBudget = std::max(1, ms);
+}
+
+void Simulator::advance() {
+  if (mode == Mode::Synchronous && system->supportsSynchronousRounds()) {
+    system->activateSynchronousRound(numThreads);
+  } else if (mode == Mode::Parallel && system->supportsParallelActivations()) {
+    system->activateInParallel(system->size(), numThreads);
+  } else {
     system->activate();
   }
 }
 
+void Simulator::stepBatch() {
+  QMutexLocker locker(&system->mutex);
+  const unsigned int size = (batchSize > 0) ? batchSize : adaptiveBatchSize;
+  QElapsedTimer timer;
+  timer.start();
+  for (unsigned int i = 0; i < size; ++i) {
+    if (isCancelled()) {
+      publish(true);
+      return;
+    }
+    advance();
+    if (system->checkTermination()) {
+      publish(true);
+      locker.unlock();
+      stop();
+      return;
+    }
+  }
+  publish(false);
+
+  if (batchSize == 0) {
+    const double budget = frameBudget * 1e6;
+    const double elapsed = std::max<qint64>(timer.nsecsElapsed(), 1);
+    const double scale = std::min(2.0, std::max(0.5, budget / elapsed));
+    const double nextSize = std::min(
+        static_cast<double>(maxAdaptiveBatchSize), adaptiveBatchSize * scale);
+    adaptiveBatchSize = static_cast<unsigned int>(std::max(1.0, nextSize));
+  }
+}
+
 int Simulator::numParticles() const {
   QMutexLocker locker(&system->mutex);
   return system->size();
@@ -82,7 +216,18 @@ int Simulator::numObjects() const {
 }
 
 QVariant Simulator::metrics() const {
-  QMutexLocker locker(&system->mutex);
+  QMutexLocker locker(&metricsMutex);
+  return publishedMetrics;
+}
+
+void Simulator::publish(bool forceMetrics) {
+  snapshots->publish(system.get());
+  if (!forceMetrics && publishTimer.isValid() &&
+      publishTimer.elapsed() < publishInterval) {
+    return;
+  }
+  publishTimer.start();
+
   QList<QVariant> metricsData;
   for (const auto& c : system->getCounts()) {
     metricsData.push_back(QVariant({c->_name, c->_value}));
@@ -94,7 +239,12 @@ QVariant Simulator::metrics() const {
       metricsData.push_back(QVariant({m->_name, m->_history.back()}));
     }
   }
-  return QVariant::fromValue(metricsData);
+  const QVariant metrics = QVariant::fromValue(metricsData);
+  {
+    QMutexLocker locker(&metricsMutex);
+    publishedMetrics = metrics;
+  }
+  emit progress(metrics);
 }
 
 void Simulator::exportMetrics() {
@@ -118,6 +268,10 @@ void Simulator::exportMetrics() {
 }
 
 void Simulator::saveScreenshotSetup(const QString filePath) {
+  if (system != nullptr) {
+    QMutexLocker locker(&system->mutex);
+    snapshots->publish(system.get());
+  }
   emit systemChanged(system);
   emit saveScreenshot(filePath);
 }
@@ -2,49 +2,109 @@
  * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
  * notice can be found at the top of main/main.cpp. */
 
+// Defines the simulator driving a particle system for the GUI and scripts. The
+// GUI application runs the simulator on a dedicated thread (see Application),
+// so its slots are commands that the GUI queues through signals and that the
+// simulator carries out one at a time on its own thread; scripts run on that
+// thread as well. Activations hold the system's mutex for at most about one
+// frame budget at a time, after which the simulator publishes what the GUI
+// shows: a render snapshot of the system (see rendersnapshot.h) and its
+// metrics. The GUI thus never reads the system while drawing.
+
 #ifndef AMOEBOTSIM_CORE_SIMULATOR_H_
 #define AMOEBOTSIM_CORE_SIMULATOR_H_
 
+#include <atomic>
 #include <memory>
 
+#include <QElapsedTimer>
+#include <QMutex>
 #include <QObject>
 #include <QTimer>
 #include <QVariant>
 
+#include "core/rendersnapshot.h"
+#include "core/scheduler.h"
 #include "core/system.h"
 
 class Simulator : public QObject {
   Q_OBJECT
 
  public:
+  // The ways a step can advance the system: by activating a single random
+  // particle, by running one synchronous round, or by performing one
+  // activation per particle with parallel asynchronous activations (see
+  // System::activateSynchronousRound and System::activateInParallel).
+  enum class Mode { Sequential, Synchronous, Parallel };
+
   Simulator();
   virtual ~Simulator();
 
   void setSystem(std::shared_ptr<System> _system);
   std::shared_ptr<System> getSystem() const;
 
+  // Returns the buffer the simulator publishes render snapshots of its system
+  // to; the buffer stays the same for the simulator's lifetime.
+  std::shared_ptr<RenderSnapshotBuffer> renderSnapshots() const;
+
  signals:
   void systemChanged(std::shared_ptr<System> _system);
   void stepDurationChanged(int ms);
+  void batchSizeChanged(int size);
   void saveScreenshot(const QString filePath);
 
   void started();
   void stopped();
 
+  // Reports the metrics of the system after the simulator has advanced it, as
+  // published by metrics(); emitted at most every publishInterval milliseconds
+  // while the simulator is running and after every other command.
+  void progress(QVariant metrics);
+
  public slots:
   // Responds to control flow signals from the GUI and scripts. Start, stop, and
   // step are self-explanatory. stepForParticleAt executes one activation for
   // the specific particle at the given node. setStepDuration updates the delay
   // in milliseconds between particle activations. runUntilTermination activates
-  // particles repeatedly until the hasTerminated condition is satisfied.
+  // particles repeatedly until the hasTerminated condition is satisfied or the
+  // run is cancelled. cancel may be called from any thread: it makes running
+  // batches and runs of runUntilTermination return early and queues a stop.
+  // Scripts check isCancelled after their commands and abort once it is true
+  // (see ScriptInterface); clearCancel drops a pending cancel when a new script
+  // starts. shutdown cancels for good: isCancelled stays true afterwards, so
+  // that nothing queued on the simulator's thread keeps the application from
+  // exiting.
+  // setMode selects what a step does (Mode::Sequential by default); modes the
+  // system does not support fall back to single activations. The synchronous
+  // and parallel modes use the given number of threads (0 uses one per core).
+  // setScheduler selects the scheduler of the current system and of every
+  // system set later (see scheduler.h); the seed is only used by the
+  // adversarial policy.
+  //
+  // While running, every tick of the step timer advances the system a batch of
+  // steps at once instead of a single one, holding the system's mutex once per
+  // batch. setBatchSize sets the number of steps per batch (1 by default); a
+  // size of 0 makes the batch size adapt so that each batch takes about the
+  // frame budget set by setFrameBudget, in milliseconds (16 by default). The
+  // Step button and scripts' step always advance by a single step.
   void start();
   void stop();
+  void cancel();
+  void clearCancel();
+  void shutdown();
+  bool isCancelled() const;
   void step();
   void stepForParticleAt(Node node);
   void setStepDuration(int ms);
   void runUntilTermination();
+  void setMode(Mode mode, int numThreads = 0);
+  void setScheduler(Scheduler::Policy policy, uint32_t seed = 0);
+  void setBatchSize(int size);
+  void setFrameBudget(int ms);
 
-  // Responds to GUI and script requests for statistics and metrics.
+  // Responds to GUI and script requests for statistics and metrics. metrics
+  // returns the metrics last published by the simulator, so it may be called
+  // from any thread without waiting for activations.
   int numParticles() const;
   int numObjects() const;
   QVariant metrics() const;
@@ -59,8 +119,43 @@ class Simulator : public QObject {
   void saveScreenshotSetup(const QString filePath);
 
  protected:
+  // Advances the system by one step as selected by setMode. The caller must
+  // hold the system's mutex.
+  void advance();
+
+  // Advances the system by one batch of steps; called on every tick of the
+  // step timer. With an adaptive batch size, the size of the next batch is
+  // scaled by the ratio of the frame budget to the time this batch took, by a
+  // factor of at most 2 either way. The adaptive size starts over from 1
+  // whenever the system or the mode changes.
+  void stepBatch();
+
+  // Publishes a render snapshot of the system, then publishes its current
+  // metrics for metrics and emits them through progress. Unless forceMetrics
+  // is true, the metrics are skipped if they were published less than
+  // publishInterval milliseconds ago. The caller must hold the system's mutex.
+  void publish(bool forceMetrics);
+
+  static const int publishInterval = 50;
+
   QTimer stepTimer;
   std::shared_ptr<System> system;
+  Mode mode;
+  unsigned int numThreads;
+  Scheduler::Policy schedulerPolicy;
+  uint32_t schedulerSeed;
+  static const unsigned int maxAdaptiveBatchSize = 1 << 20;
+  unsigned int batchSize;          // 0 if adaptive.
+  unsigned int adaptiveBatchSize;  // The size of the next adaptive batch.
+  int frameBudget;
+  std::atomic<bool> cancelRequested;
+  std::atomic<bool> shutDown;
+
+  std::shared_ptr<RenderSnapshotBuffer> snapshots;
+
+  mutable QMutex metricsMutex;
+  QVariant publishedMetrics;
+  QElapsedTimer publishTimer;
 };
 
 #endif  // AMOEBOTSIM_CORE_SIMULATOR_H_
@@ -0,0 +1,22 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/statetally.h"
+
+thread_local std::vector<StateTally::Change>* StateTally::boundLog = nullptr;
+
+StateTally::StateTally(const QString name)
+  : _name(name),
+    _total(0) {}
+
+void StateTally::applyLog(const std::vector<Change>& log) {
+  Q_ASSERT(boundLog == nullptr);
+  for (const Change& change : log) {
+    if (change.delta > 0) {
+      change.tally->enter(change.state);
+    } else {
+      change.tally->leave(change.state);
+    }
+  }
+}
@@ -0,0 +1,179 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines tallies of how many particles hold each value of an enumerated piece
+// of particle memory (e.g., a State enum), kept up to date as particles change
+// state. Systems use them to evaluate termination conditions such as "all
+// particles are retired" in constant time instead of scanning every particle.
+
+#ifndef AMOEBOTSIM_CORE_STATETALLY_H_
+#define AMOEBOTSIM_CORE_STATETALLY_H_
+
+#include <initializer_list>
+#include <vector>
+
+#include <QString>
+#include <QtGlobal>
+
+class StateTally {
+  template<class StateType>
+  friend class TrackedState;
+
+ public:
+  // Constructs a new, empty tally with the given human-readable name.
+  StateTally(const QString name);
+
+  // Returns the number of particles currently holding the given state. total
+  // returns the number of particles tracked by this tally, which equals the
+  // sum of the counts over all states.
+  template<class StateType>
+  unsigned int count(StateType state) const;
+  unsigned int total() const;
+
+  // Returns true if and only if every tracked particle holds one of the given
+  // states.
+  template<class StateType>
+  bool allIn(std::initializer_list<StateType> states) const;
+
+  const QString _name;
+
+  // Functions for particles changing state concurrently (see
+  // AmoebotSystem::activateInParallel). While a log is bound to the calling
+  // thread with bindLog, tally changes made on that thread are appended to the
+  // log instead of applied, so no two threads ever write the same tally;
+  // bindLog returns the previously bound log, and nullptr unbinds it. applyLog
+  // then applies the logged changes in order.
+  struct Change {
+    StateTally* tally;
+    int state;
+    int delta;
+  };
+  static std::vector<Change>* bindLog(std::vector<Change>* log);
+  static void applyLog(const std::vector<Change>& log);
+
+ private:
+  // Functions for TrackedState to report a particle entering (resp., leaving)
+  // the given state.
+  void enter(int state);
+  void leave(int state);
+
+  std::vector<unsigned int> _counts;  // Indexed by the state's integer value.
+  unsigned int _total;
+
+  static thread_local std::vector<Change>* boundLog;
+};
+
+// A drop-in replacement for a particle's enum-valued member variable that
+// reports every change of its value to a StateTally. It converts implicitly to
+// and is assignable from StateType, so comparisons, switches, and assignments
+// on the member compile unchanged. The particle is counted from construction
+// until destruction of the member, so deleting a removed particle also removes
+// it from the tally. Copies (e.g., a snapshot of a neighbor taken by value
+// during an activation) are counted while they exist, so the tally is exact
+// whenever no such temporaries are alive, i.e., between activations.
+template<class StateType>
+class TrackedState {
+ public:
+  TrackedState(StateTally& tally, StateType state);
+  TrackedState(const TrackedState& other);
+  ~TrackedState();
+
+  TrackedState& operator=(StateType state);
+  TrackedState& operator=(const TrackedState& other);
+  operator StateType() const;
+
+ private:
+  StateTally& _tally;
+  StateType _state;
+};
+
+template<class StateType>
+unsigned int StateTally::count(StateType state) const {
+  const unsigned int index = static_cast<unsigned int>(state);
+  return (index < _counts.size()) ? _counts[index] : 0;
+}
+
+inline unsigned int StateTally::total() const {
+  return _total;
+}
+
+template<class StateType>
+bool StateTally::allIn(std::initializer_list<StateType> states) const {
+  unsigned int numInStates = 0;
+  for (StateType state : states) {
+    numInStates += count(state);
+  }
+
+  return numInStates == _total;
+}
+
+inline std::vector<StateTally::Change>* StateTally::bindLog(
+    std::vector<Change>* log) {
+  std::vector<Change>* previous = boundLog;
+  boundLog = log;
+  return previous;
+}
+
+inline void StateTally::enter(int state) {
+  if (boundLog != nullptr) {
+    boundLog->push_back({this, state, 1});
+    return;
+  }
+  if (static_cast<unsigned int>(state) >= _counts.size()) {
+    _counts.resize(state + 1, 0);
+  }
+  ++_counts[state];
+  ++_total;
+}
+
+inline void StateTally::leave(int state) {
+  if (boundLog != nullptr) {
+    boundLog->push_back({this, state, -1});
+    return;
+  }
+  Q_ASSERT(static_cast<unsigned int>(state) < _counts.size() &&
+           _counts[state] > 0);
+  --_counts[state];
+  --_total;
+}
+
+template<class StateType>
+TrackedState<StateType>::TrackedState(StateTally& tally, StateType state)
+  : _tally(tally),
+    _state(state) {
+  _tally.enter(static_cast<int>(_state));
+}
+
+template<class StateType>
+TrackedState<StateType>::TrackedState(const TrackedState& other)
+  : TrackedState(other._tally, other._state) {}
+
+template<class StateType>
+TrackedState<StateType>::~TrackedState() {
+  _tally.leave(static_cast<int>(_state));
+}
+
+template<class StateType>
+TrackedState<StateType>& TrackedState<StateType>::operator=(StateType state) {
+  if (state != _state) {
+    _tally.leave(static_cast<int>(_state));
+    _tally.enter(static_cast<int>(state));
+    _state = state;
+  }
+
+  return *this;
+}
+
+template<class StateType>
+TrackedState<StateType>& TrackedState<StateType>::operator=(
+    const TrackedState& other) {
+  return *this = static_cast<StateType>(other);
+}
+
+template<class StateType>
+TrackedState<StateType>::operator StateType() const {
+  return _state;
+}
+
+#endif  // AMOEBOTSIM_CORE_STATETALLY_H_
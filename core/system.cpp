@@ -4,6 +4,8 @@
 
 #include "core/system.h"
 
+#include <QtGlobal>
+
 SystemIterator::SystemIterator(const System* system, int pos)
   : _pos(pos)
   , system(system) {}
@@ -29,6 +31,60 @@ SystemIterator System::end() const {
   return SystemIterator(this, size());
 }
 
+const Particle* System::particleAt(const Node& node) const {
+  for (const Particle& p : *this) {
+    if (p.head == node || (p.isExpanded() && p.tail() == node)) {
+      return &p;
+    }
+  }
+  return nullptr;
+}
+
+void System::takeChangedParticles(std::vector<int>& indices) {
+  for (unsigned int i = 0; i < size(); ++i) {
+    indices.push_back(i);
+  }
+}
+
+Appearance System::appearanceAt(int i) {
+  return at(i).appearance();
+}
+
+bool System::supportsSynchronousRounds() const {
+  return false;
+}
+
+void System::activateSynchronousRound(unsigned int numThreads) {
+  Q_UNUSED(numThreads);
+  Q_ASSERT(false);  // This system does not support synchronous rounds.
+}
+
+bool System::supportsParallelActivations() const {
+  return false;
+}
+
+void System::activateInParallel(unsigned int numActivations,
+                                unsigned int numThreads) {
+  Q_UNUSED(numActivations);
+  Q_UNUSED(numThreads);
+  Q_ASSERT(false);  // This system does not support parallel activations.
+}
+
 bool System::hasTerminated() const {
   return false;
 }
+
+bool System::checkTermination() {
+  if (++_callsSinceTerminationCheck < _terminationCheckInterval) {
+    return false;
+  }
+  _callsSinceTerminationCheck = 0;
+
+  return hasTerminated();
+}
+
+void System::setTerminationCheckInterval(unsigned int interval) {
+  Q_ASSERT(interval > 0);
+  _terminationCheckInterval = interval;
+  _callsSinceTerminationCheck = 0;
+}
@@ -10,6 +10,7 @@
 
 #include <deque>
 #include <set>
+#include <vector>
 
 #include <QMutex>
 #include <QString>
@@ -18,6 +19,7 @@
 #include "core/node.h"
 #include "core/object.h"
 #include "core/particle.h"
+#include "core/scheduler.h"
 
 // System is forward declared to avoid a cyclic dependency with SystemIterator.
 class System;
@@ -48,6 +50,31 @@ class System {
   virtual void activate() = 0;
   virtual void activateParticleAt(Node node) = 0;
 
+  // Selects the scheduler deciding which particle activate activates next (see
+  // scheduler.h); the seed is only used by the adversarial policy. Must be
+  // overridden by any system subclasses.
+  virtual void setScheduler(const Scheduler::Policy policy,
+                            const uint32_t seed = 0) = 0;
+
+  // Functions for synchronous rounds, in which every particle is activated once
+  // with all particles reading the state of the previous round. Systems opt in
+  // by overriding supportsSynchronousRounds to return true (it returns false by
+  // default); activateSynchronousRound then runs one such round using the given
+  // number of threads. See amoebotsystem.h for more detailed documentation.
+  virtual bool supportsSynchronousRounds() const;
+  virtual void activateSynchronousRound(unsigned int numThreads);
+
+  // Functions for parallel asynchronous activations, which have the same
+  // outcome as activating random particles one at a time but run activations
+  // of particles far enough apart from each other concurrently. Systems opt in
+  // by overriding supportsParallelActivations to return true (it returns false
+  // by default); activateInParallel then performs the given number of
+  // activations using the given number of threads. See amoebotsystem.h for
+  // more detailed documentation.
+  virtual bool supportsParallelActivations() const;
+  virtual void activateInParallel(unsigned int numActivations,
+                                  unsigned int numThreads);
+
   // Returns the number of particles in the system. Must be overridden by any
   // system subclasses.
   virtual unsigned int size() const = 0;
@@ -59,9 +86,30 @@ class System {
   // overridden by any system subclasses.
   virtual const Particle& at(int i) const = 0;
 
+  // Returns the particle occupying the given node with its head or tail, or
+  // nullptr if the node is unoccupied. By default, this scans every particle;
+  // see amoebotsystem.h for an override using its occupancy index.
+  virtual const Particle* particleAt(const Node& node) const;
+
   // Returns a reference to the object list.
   virtual const std::deque<Object*>& getObjects() const = 0;
 
+  // Appends to the given vector the indices (in the particle list) of the
+  // particles whose appearance may have changed since the last call, each at
+  // most once, for renderers keeping a copy of the particles' appearance (see
+  // RenderSnapshotBuffer). Indices may be out of range if particles have been
+  // removed since. The first call appends every particle. By default, every
+  // call appends every particle; see amoebotsystem.h for an override tracking
+  // the changes, which only tracks activated and moved particles and their
+  // neighbors. Systems whose particles change the state of particles further
+  // away must report those changes (see AmoebotSystem::markChanged).
+  virtual void takeChangedParticles(std::vector<int>& indices);
+
+  // Returns the appearance of the particle at the specified index. By default,
+  // this calls the particle's appearance functions; see amoebotsystem.h for an
+  // override caching the result until the particle may have changed.
+  virtual Appearance appearanceAt(int i);
+
   // STL-like begin and end functions for particle-accessing iterators.
   SystemIterator begin() const;
   SystemIterator end() const;
@@ -74,8 +122,23 @@ class System {
   virtual Measure& getMeasure(QString name) const = 0;
   virtual const QString metricsAsJSON() const = 0;
 
+  // Returns true if and only if the algorithm running on this system has
+  // terminated. Systems should keep this cheap (see StateTally), since it is
+  // evaluated between activations.
   virtual bool hasTerminated() const;
 
+  // Evaluates hasTerminated, but only on every interval-th call; all other
+  // calls return false without evaluating it. The interval defaults to 1, so
+  // every call is a check. Systems whose termination condition can only be
+  // decided by a full scan can raise the interval, trading detection latency
+  // for fewer scans: the simulator uses checkTermination after each
+  // activation, so such a run may continue for up to interval - 1 activations
+  // after its algorithm has terminated, and the activation, round and movement
+  // counts at which it stops can be that much higher than with an interval of
+  // 1, even with a fixed seed. Setting the interval restarts the cadence.
+  bool checkTermination();
+  void setTerminationCheckInterval(unsigned int interval);
+
  protected:
   // Checks whether the particle system forms one connected component.
   template<class ParticleContainer>
@@ -83,6 +146,10 @@ class System {
 
  public:
   QMutex mutex;
+
+ private:
+  unsigned int _terminationCheckInterval = 1;
+  unsigned int _callsSinceTerminationCheck = 0;
 };
 
 template<class ParticleContainer>
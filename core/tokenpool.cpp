@@ -0,0 +1,78 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/tokenpool.h"
+
+#include <new>
+
+namespace {
+
+// Blocks are grouped into size classes of this granularity; larger blocks than
+// the largest class bypass the pool.
+const std::size_t granularity = 16;
+const std::size_t numSizeClasses = 32;
+const std::size_t maxFreeBlocks = 4096;
+
+// A freed block stores the link to the next free block of its size class.
+struct FreeBlock {
+  FreeBlock* next;
+};
+
+struct FreeLists {
+  ~FreeLists() {
+    for (std::size_t i = 0; i < numSizeClasses; ++i) {
+      while (heads[i] != nullptr) {
+        FreeBlock* block = heads[i];
+        heads[i] = block->next;
+        ::operator delete(block);
+      }
+    }
+  }
+
+  FreeBlock* heads[numSizeClasses] = {};
+  std::size_t lengths[numSizeClasses] = {};
+};
+
+FreeLists& freeLists() {
+  static thread_local FreeLists lists;
+  return lists;
+}
+
+std::size_t sizeClassOf(std::size_t size) {
+  return (size + granularity - 1) / granularity - 1;
+}
+
+}  // namespace
+
+void* TokenPool::allocate(std::size_t size) {
+  const std::size_t sizeClass = sizeClassOf(size);
+  if (sizeClass >= numSizeClasses) {
+    return ::operator new(size);
+  }
+
+  FreeLists& lists = freeLists();
+  FreeBlock* block = lists.heads[sizeClass];
+  if (block == nullptr) {
+    return ::operator new((sizeClass + 1) * granularity);
+  }
+  lists.heads[sizeClass] = block->next;
+  --lists.lengths[sizeClass];
+
+  return block;
+}
+
+void TokenPool::deallocate(void* ptr, std::size_t size) {
+  const std::size_t sizeClass = sizeClassOf(size);
+  FreeLists& lists = freeLists();
+  if (sizeClass >= numSizeClasses ||
+      lists.lengths[sizeClass] >= maxFreeBlocks) {
+    ::operator delete(ptr);
+    return;
+  }
+
+  FreeBlock* block = static_cast<FreeBlock*>(ptr);
+  block->next = lists.heads[sizeClass];
+  lists.heads[sizeClass] = block;
+  ++lists.lengths[sizeClass];
+}
@@ -0,0 +1,55 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the memory pool tokens are allocated from. Token-passing algorithms
+// create and destroy tokens at a high rate, so AmoebotParticle::makeToken
+// allocates each token together with its reference count through
+// TokenAllocator, which keeps freed blocks on per-thread free lists grouped by
+// size instead of returning them to the heap. Every block is allocated
+// individually, so a token may safely be destroyed on a different thread than
+// the one that created it.
+
+#ifndef AMOEBOTSIM_CORE_TOKENPOOL_H_
+#define AMOEBOTSIM_CORE_TOKENPOOL_H_
+
+#include <cstddef>
+
+class TokenPool {
+ public:
+  // Allocates (resp., deallocates) a block of the given size, reusing a block
+  // freed earlier on the calling thread if possible.
+  static void* allocate(std::size_t size);
+  static void deallocate(void* ptr, std::size_t size);
+};
+
+// A minimal standard allocator drawing from TokenPool, meant for use with
+// std::allocate_shared.
+template<class T>
+class TokenAllocator {
+ public:
+  using value_type = T;
+
+  TokenAllocator() = default;
+  template<class U>
+  TokenAllocator(const TokenAllocator<U>&) {}
+
+  T* allocate(std::size_t n) {
+    return static_cast<T*>(TokenPool::allocate(n * sizeof(T)));
+  }
+  void deallocate(T* ptr, std::size_t n) {
+    TokenPool::deallocate(ptr, n * sizeof(T));
+  }
+};
+
+template<class T, class U>
+bool operator==(const TokenAllocator<T>&, const TokenAllocator<U>&) {
+  return true;
+}
+
+template<class T, class U>
+bool operator!=(const TokenAllocator<T>&, const TokenAllocator<U>&) {
+  return false;
+}
+
+#endif  // AMOEBOTSIM_CORE_TOKENPOOL_H_
@@ -0,0 +1,94 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "core/workerpool.h"
+
+#include <QtGlobal>
+
+WorkerPool::WorkerPool(unsigned int numThreads)
+  : _task(nullptr),
+    _numTasks(0),
+    _generation(0),
+    _nextTask(0),
+    _numBusyWorkers(0),
+    _stopping(false) {
+  Q_ASSERT(numThreads > 0);
+
+  for (unsigned int i = 1; i < numThreads; ++i) {
+    _workers.emplace_back(&WorkerPool::workerLoop, this);
+  }
+}
+
+WorkerPool::~WorkerPool() {
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _stopping = true;
+  }
+  _wakeup.notify_all();
+  for (auto& worker : _workers) {
+    worker.join();
+  }
+}
+
+unsigned int WorkerPool::numThreads() const {
+  return _workers.size() + 1;
+}
+
+void WorkerPool::run(int numTasks, const std::function<void(int)>& task) {
+  if (numTasks <= 0) {
+    return;
+  } else if (_workers.empty() || numTasks == 1) {
+    for (int i = 0; i < numTasks; ++i) {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _task = &task;
+    _numTasks = numTasks;
+    _nextTask.store(0);
+    _numBusyWorkers = _workers.size();
+    ++_generation;
+  }
+  _wakeup.notify_all();
+
+  runTasks();
+
+  std::unique_lock<std::mutex> lock(_mutex);
+  _done.wait(lock, [this]() { return _numBusyWorkers == 0; });
+  _task = nullptr;
+}
+
+void WorkerPool::runTasks() {
+  for (int i = _nextTask.fetch_add(1); i < _numTasks;
+       i = _nextTask.fetch_add(1)) {
+    (*_task)(i);
+  }
+}
+
+void WorkerPool::workerLoop() {
+  unsigned long long seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(_mutex);
+      _wakeup.wait(lock, [&]() {
+        return _stopping || _generation != seenGeneration;
+      });
+      if (_stopping) {
+        return;
+      }
+      seenGeneration = _generation;
+    }
+
+    runTasks();
+
+    {
+      std::lock_guard<std::mutex> lock(_mutex);
+      --_numBusyWorkers;
+    }
+    _done.notify_one();
+  }
+}
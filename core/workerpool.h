@@ -0,0 +1,61 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a small pool of persistent worker threads for running the parallel
+// phases of a system's activations (see AmoebotSystem::activateSynchronousRound
+// and AmoebotSystem::activateInParallel).
+// A run hands out task indices to the workers and the calling thread alike and
+// returns once every task has finished, so each parallel phase costs a wakeup
+// rather than spawning threads.
+
+#ifndef AMOEBOTSIM_CORE_WORKERPOOL_H_
+#define AMOEBOTSIM_CORE_WORKERPOOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkerPool {
+ public:
+  // Constructs a pool using the given number of threads in total, including
+  // the thread calling run; a pool of one thread runs all tasks on the caller.
+  explicit WorkerPool(unsigned int numThreads);
+
+  // Stops and joins all worker threads.
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool&) = delete;
+  WorkerPool& operator=(const WorkerPool&) = delete;
+
+  // Returns the number of threads this pool runs tasks on.
+  unsigned int numThreads() const;
+
+  // Calls task(i) for every i in [0, numTasks) and returns once all calls have
+  // finished. Tasks may run in any order and concurrently with each other.
+  void run(int numTasks, const std::function<void(int)>& task);
+
+ private:
+  // Claims and runs tasks of the current run until none are left.
+  void runTasks();
+  void workerLoop();
+
+  std::vector<std::thread> _workers;
+  std::mutex _mutex;
+  std::condition_variable _wakeup;
+  std::condition_variable _done;
+
+  // The current run, identified by its generation so that workers wake up
+  // exactly once per run.
+  const std::function<void(int)>* _task;
+  int _numTasks;
+  unsigned long long _generation;
+  std::atomic<int> _nextTask;
+  int _numBusyWorkers;
+  bool _stopping;
+};
+
+#endif  // AMOEBOTSIM_CORE_WORKERPOOL_H_
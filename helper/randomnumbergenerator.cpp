@@ -4,4 +4,45 @@
 
 #include "helper/randomnumbergenerator.h"
 
-std::mt19937 RandomNumberGenerator::rng;
+thread_local RandomNumberGenerator::Engine* RandomNumberGenerator::boundEngine = nullptr;
+
+RandomEngine::RandomEngine(const uint32_t seed, const Kind kind)
+    : _kind(kind)
+{
+    if(_kind == Kind::MT19937) {
+        new (&_mt) std::mt19937(seed);
+        _hasSpare = false;
+    } else {
+        this->seed(seed);
+    }
+}
+
+void RandomEngine::seed(const uint32_t seed)
+{
+    if(_kind == Kind::MT19937) {
+        _mt.seed(seed);
+    } else {
+        // Expand the 32-bit seed into the 256-bit state using splitmix64, as
+        // recommended by the authors of xoshiro256**; this never yields the
+        // all-zero state.
+        uint64_t x = seed;
+        for(auto& word : _state) {
+            uint64_t z = (x += 0x9e3779b97f4a7c15);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+            word = z ^ (z >> 31);
+        }
+    }
+    _hasSpare = false;
+}
+
+const char* RandomEngine::name(const Kind kind)
+{
+    switch(kind) {
+    case Kind::MT19937:
+        return "mt19937";
+    case Kind::Xoshiro256StarStar:
+        return "xoshiro256**";
+    }
+    return "";
+}
@@ -7,12 +7,82 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstdint>
+#include <limits>
+#include <new>
 #include <random>
 
+// A random engine that is either a Mersenne Twister (std::mt19937) or a
+// xoshiro256** generator. The Mersenne Twister is the default; its draws are
+// made through the standard library distributions, so runs using it reproduce
+// earlier mt19937 runs with the same seed. xoshiro256** is several times faster
+// and has a much smaller state; with it, bounded integers are drawn using
+// Lemire's multiply-and-reject method and each 64-bit output is split into two
+// 32-bit draws. Both kinds satisfy UniformRandomBitGenerator with 32-bit
+// outputs, so the engine can also be passed to standard library algorithms.
+class RandomEngine
+{
+public:
+    enum class Kind { MT19937, Xoshiro256StarStar };
+
+    using result_type = uint32_t;
+
+    explicit RandomEngine(const uint32_t seed = std::mt19937::default_seed,
+                          const Kind kind = Kind::MT19937);
+
+    RandomEngine(const RandomEngine&) = delete;
+    RandomEngine& operator=(const RandomEngine&) = delete;
+
+    // Restarts the engine from the given seed, keeping its kind.
+    void seed(const uint32_t seed);
+    Kind kind() const;
+
+    // Returns the name of the given kind ("mt19937" or "xoshiro256**").
+    static const char* name(const Kind kind);
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+    result_type operator()();
+
+    // Draws an integer in [0, bound) without bias. Only used for xoshiro256**.
+    uint32_t bounded(const uint32_t bound);
+
+    // Draws a double in [0, 1) from 53 random bits. Only used for xoshiro256**.
+    double unit();
+
+private:
+    uint64_t nextXoshiro();
+
+    // Only the state of the engine's kind is constructed, so that xoshiro256**
+    // engines, which are created per block or task in parallel activations, do
+    // not construct and seed the several kilobytes of a Mersenne Twister.
+    Kind _kind;
+    union {
+        std::mt19937 _mt;
+        uint64_t _state[4];
+    };
+    uint32_t _spare;
+    bool _hasSpare;
+};
+
+// Provides random draws to particles and systems. The draws come from the
+// engine bound to the calling thread, which is the engine of the AmoebotSystem
+// being constructed or activated on that thread (see AmoebotSystem). Every
+// system thus owns its random state, making runs reproducible from the
+// system's seed and allowing independent systems to run on different threads.
 class RandomNumberGenerator
 {
 public:
-    RandomNumberGenerator();
+    using Engine = RandomEngine;
+
+    // Binds the given engine to the calling thread, so that subsequent draws on
+    // this thread use it; nullptr unbinds the current engine. Returns the
+    // previously bound engine.
+    static Engine* bind(Engine* engine);
+
+    // Returns a seed drawn from a random device, falling back to the clock if
+    // the device has no entropy.
+    static uint32_t randomSeed();
 
 protected:
     static int randInt(const int from, const int toNotIncluding);
@@ -24,33 +94,104 @@ protected:
     template <class Iterator>
     void shuffle(Iterator firxt, Iterator last);
 
+    // Returns the engine bound to the calling thread. If no engine is bound,
+    // returns a randomly seeded fallback engine private to the thread.
+    static Engine& engine();
+
 private:
-    static std::mt19937 rng;
+    static thread_local Engine* boundEngine;
 };
 
-inline RandomNumberGenerator::RandomNumberGenerator()
-{
-    static bool initialized = false;
-    if(!initialized) {
-        uint32_t seed;
-        std::random_device device;
-        if(device.entropy() == 0) {
-            auto duration = std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::time_point::min();
-            seed = duration.count();
-        } else {
-            std::uniform_int_distribution<uint32_t> dist(std::numeric_limits<uint32_t>::min(),
-                                                         std::numeric_limits<uint32_t>::max());
-            seed = dist(device);
+inline RandomEngine::Kind RandomEngine::kind() const
+{
+    return _kind;
+}
+
+inline uint64_t RandomEngine::nextXoshiro()
+{
+    const uint64_t result = _state[1] * 5;
+    const uint64_t rotated = (result << 7) | (result >> 57);
+    const uint64_t t = _state[1] << 17;
+    _state[2] ^= _state[0];
+    _state[3] ^= _state[1];
+    _state[1] ^= _state[2];
+    _state[0] ^= _state[3];
+    _state[2] ^= t;
+    _state[3] = (_state[3] << 45) | (_state[3] >> 19);
+    return rotated * 9;
+}
+
+inline RandomEngine::result_type RandomEngine::operator()()
+{
+    if(_kind == Kind::MT19937) {
+        return _mt();
+    } else if(_hasSpare) {
+        _hasSpare = false;
+        return _spare;
+    } else {
+        const uint64_t draw = nextXoshiro();
+        _spare = static_cast<uint32_t>(draw);
+        _hasSpare = true;
+        return static_cast<uint32_t>(draw >> 32);
+    }
+}
+
+inline uint32_t RandomEngine::bounded(const uint32_t bound)
+{
+    uint64_t product = static_cast<uint64_t>((*this)()) * bound;
+    uint32_t low = static_cast<uint32_t>(product);
+    if(low < bound) {
+        const uint32_t threshold = -bound % bound;
+        while(low < threshold) {
+            product = static_cast<uint64_t>((*this)()) * bound;
+            low = static_cast<uint32_t>(product);
         }
-        rng.seed(seed);
-        initialized = true;
     }
+    return static_cast<uint32_t>(product >> 32);
+}
+
+inline double RandomEngine::unit()
+{
+    return (nextXoshiro() >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline RandomNumberGenerator::Engine* RandomNumberGenerator::bind(Engine* engine)
+{
+    Engine* previous = boundEngine;
+    boundEngine = engine;
+    return previous;
+}
+
+inline uint32_t RandomNumberGenerator::randomSeed()
+{
+    std::random_device device;
+    if(device.entropy() == 0) {
+        auto duration = std::chrono::high_resolution_clock::now() - std::chrono::high_resolution_clock::time_point::min();
+        return duration.count();
+    } else {
+        std::uniform_int_distribution<uint32_t> dist(std::numeric_limits<uint32_t>::min(),
+                                                     std::numeric_limits<uint32_t>::max());
+        return dist(device);
+    }
+}
+
+inline RandomNumberGenerator::Engine& RandomNumberGenerator::engine()
+{
+    if(boundEngine == nullptr) {
+        static thread_local Engine fallback(randomSeed());
+        return fallback;
+    }
+    return *boundEngine;
 }
 
 inline int RandomNumberGenerator::randInt(const int from, const int toNotIncluding)
 {
-    std::uniform_int_distribution<int> dist(from, toNotIncluding - 1);
-    return dist(rng);
+    Engine& e = engine();
+    if(e.kind() == Engine::Kind::MT19937) {
+        std::uniform_int_distribution<int> dist(from, toNotIncluding - 1);
+        return dist(e);
+    }
+    return from + static_cast<int>(e.bounded(static_cast<uint32_t>(toNotIncluding - from)));
 }
 
 inline int RandomNumberGenerator::randDir()
@@ -60,25 +201,39 @@ inline int RandomNumberGenerator::randDir()
 
 inline float RandomNumberGenerator::randFloat(const float from, const float toNotIncluding)
 {
-    std::uniform_real_distribution<float> dist(from, toNotIncluding);
-    return dist(rng);
+    Engine& e = engine();
+    if(e.kind() == Engine::Kind::MT19937) {
+        std::uniform_real_distribution<float> dist(from, toNotIncluding);
+        return dist(e);
+    }
+    const float unit = (e() >> 8) * (1.0f / 16777216.0f);
+    return from + unit * (toNotIncluding - from);
 }
 
 inline double RandomNumberGenerator::randDouble(const double from, const double toNotIncluding)
 {
-    std::uniform_real_distribution<double> dist(from, toNotIncluding);
-    return dist(rng);
+    Engine& e = engine();
+    if(e.kind() == Engine::Kind::MT19937) {
+        std::uniform_real_distribution<double> dist(from, toNotIncluding);
+        return dist(e);
+    }
+    return from + e.unit() * (toNotIncluding - from);
 }
 
 inline bool RandomNumberGenerator::randBool(const double trueProb)
 {
-    return (randFloat(0, 1) < trueProb);
+    Engine& e = engine();
+    if(e.kind() == Engine::Kind::MT19937) {
+        return (randFloat(0, 1) < trueProb);
+    }
+    // A single 32-bit draw is precise enough for a coin flip.
+    return (e() * (1.0 / 4294967296.0) < trueProb);
 }
 
 template <class Iterator>
 void RandomNumberGenerator::shuffle(Iterator first, Iterator last)
 {
-    std::shuffle(first, last, rng);
+    std::shuffle(first, last, engine());
 }
 
 #endif  // AMOEBOTSIM_HELPER_RANDOMNUMBERGENERATOR_H_
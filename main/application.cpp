@@ -12,8 +12,15 @@
 
 #include "ui/visitem.h"
 
+Q_DECLARE_METATYPE(Node)
+Q_DECLARE_METATYPE(std::shared_ptr<System>)
+
 Application::Application(int argc, char *argv[])
     : QGuiApplication(argc, argv) {
+  // Register the types passed between the GUI and the simulator's thread.
+  qRegisterMetaType<Node>();
+  qRegisterMetaType<std::shared_ptr<System>>();
+
   // Setup the parameter list model.
   parameterModel = new ParameterListModel();
   engine.rootContext()->setContextProperty("parameterModel", parameterModel);
@@ -24,9 +31,10 @@ Application::Application(int argc, char *argv[])
   auto qmlRoot = engine.rootObjects().first();
   auto vis = qmlRoot->findChild<VisItem*>();
   auto slider = qmlRoot->findChild<QObject*>("stepDurationSlider");
-  connect(vis, &VisItem::beforeRendering,
-          [this, qmlRoot](){
-            QMetaObject::invokeMethod(qmlRoot, "setMetrics", Q_ARG(QVariant, sim.metrics()));
+  auto batchSlider = qmlRoot->findChild<QObject*>("batchSizeSlider");
+  connect(&sim, &Simulator::progress, qmlRoot,
+          [qmlRoot](QVariant metrics){
+            QMetaObject::invokeMethod(qmlRoot, "setMetrics", Q_ARG(QVariant, metrics));
           }
   );
   connect(vis, &VisItem::inspectParticle,
@@ -49,47 +57,86 @@ Application::Application(int argc, char *argv[])
   connect(qmlRoot, SIGNAL(instantiate(QString)),
           parameterModel, SLOT(createSystem(QString)));
   for (Algorithm* alg : parameterModel->getAlgorithmList()->getAlgs()) {
-    connect(alg, &Algorithm::log, [qmlRoot](const QString msg, const bool isError){
+    connect(alg, &Algorithm::log, qmlRoot, [qmlRoot](const QString msg, const bool isError){
       QMetaObject::invokeMethod(qmlRoot, "log", Q_ARG(QVariant, msg), Q_ARG(QVariant, isError));
     });
     connect(alg, &Algorithm::setSystem, &sim, &Simulator::setSystem);
+    alg->moveToThread(&simThread);
   }
 
-  // setup connections between GUI and Simulator
+  // setup connections between GUI and Simulator. The simulator lives on its own
+  // thread, so these are queued, except that stop cancels running activations
+  // directly and screenshots are taken before the simulator continues.
+  vis->setRenderSnapshots(sim.renderSnapshots());
   connect(&sim, &Simulator::systemChanged, vis, &VisItem::systemChanged);
-  connect(&sim, &Simulator::saveScreenshot, vis, &VisItem::saveScreenshot);
+  connect(&sim, &Simulator::saveScreenshot, vis, &VisItem::saveScreenshot,
+          Qt::BlockingQueuedConnection);
   connect(qmlRoot, SIGNAL(start()), &sim, SLOT(start()));
-  connect(qmlRoot, SIGNAL(stop()), &sim, SLOT(stop()));
+  connect(qmlRoot, SIGNAL(stop()), &sim, SLOT(cancel()), Qt::DirectConnection);
   connect(qmlRoot, SIGNAL(step()), &sim, SLOT(step()));
   connect(qmlRoot, SIGNAL(exportMetrics()), &sim, SLOT(exportMetrics()));
-  connect(&sim, &Simulator::started,
+  connect(&sim, &Simulator::started, qmlRoot,
           [qmlRoot](){
             QMetaObject::invokeMethod(qmlRoot, "setLabelStop");
           }
   );
-  connect(&sim, &Simulator::stopped,
+  connect(&sim, &Simulator::stopped, qmlRoot,
           [qmlRoot](){
             QMetaObject::invokeMethod(qmlRoot, "setLabelStart");
           }
   );
   connect(vis, &VisItem::stepForParticleAt, &sim, &Simulator::stepForParticleAt);
   connect(slider, SIGNAL(stepDurationChanged(int)), &sim, SLOT(setStepDuration(int)));
-  connect(&sim, &Simulator::stepDurationChanged,
+  connect(&sim, &Simulator::stepDurationChanged, slider,
           [slider](const int& ms){
             QMetaObject::invokeMethod(slider, "setStepDuration", Q_ARG(QVariant, QVariant(ms)));
           }
   );
+  connect(batchSlider, SIGNAL(batchSizeChanged(int)), &sim, SLOT(setBatchSize(int)));
+  connect(&sim, &Simulator::batchSizeChanged, batchSlider,
+          [batchSlider](const int& size){
+            QMetaObject::invokeMethod(batchSlider, "setBatchSize", Q_ARG(QVariant, QVariant(size)));
+          }
+  );
 
-  // setup scripting
-  scriptEngine = std::make_shared<ScriptEngine>(sim, vis, parameterModel->getAlgorithmList());
-  connect(scriptEngine.get(), &ScriptEngine::log,
+  // Set default step duration and batch size, then start the simulator's thread.
+  sim.setStepDuration(0);
+  sim.setBatchSize(1);
+  sim.moveToThread(&simThread);
+  simThread.start();
+
+  // setup scripting. The script engine is created on the simulator's thread,
+  // where scripts then run alongside the simulator and the algorithms.
+  QMetaObject::invokeMethod(&sim, [this, vis](){
+    scriptEngine = std::make_shared<ScriptEngine>(sim, vis, parameterModel->getAlgorithmList());
+  }, Qt::BlockingQueuedConnection);
+  connect(scriptEngine.get(), &ScriptEngine::log, qmlRoot,
           [qmlRoot](const QString msg, const bool isError){
             QMetaObject::invokeMethod(qmlRoot, "log", Q_ARG(QVariant, msg), Q_ARG(QVariant, isError));
           }
   );
   qmlRoot->findChild<QObject*>("runScriptFileDialog")->setProperty("executableDir", QDir::currentPath());
   connect(qmlRoot, SIGNAL(runScript(QString)), scriptEngine.get(), SLOT(runScript(QString)));
+}
 
-  // Set default step duration.
-  sim.setStepDuration(0);
+Application::~Application() {
+  // Cancel everything on the simulator's thread for good, which also aborts a
+  // running script, and then hand the simulator and the algorithms back to this
+  // thread from there. Until that is done, a script may still be waiting on
+  // this thread (e.g., for a screenshot), so keep processing events here
+  // instead of blocking on the simulator's thread.
+  sim.shutdown();
+  QThread* mainThread = thread();
+  QMetaObject::invokeMethod(&sim, [this, mainThread](){
+    sim.stop();
+    scriptEngine.reset();
+    for (Algorithm* alg : parameterModel->getAlgorithmList()->getAlgs()) {
+      alg->moveToThread(mainThread);
+    }
+    sim.moveToThread(mainThread);
+    simThread.quit();
+  }, Qt::QueuedConnection);
+  while (!simThread.wait(10)) {
+    processEvents();
+  }
 }
@@ -9,6 +9,7 @@
 
 #include <QGuiApplication>
 #include <QQmlApplicationEngine>
+#include <QThread>
 
 #include "core/simulator.h"
 #include "script/scriptengine.h"
@@ -19,8 +20,17 @@ class Application : public QGuiApplication {
  public:
   explicit Application(int argc, char *argv[]);
 
+  // Stops the simulator and its thread, returning the simulator and the
+  // algorithms to the main thread so that they are destroyed there.
+  ~Application();
+
  protected:
   QQmlApplicationEngine engine;
+
+  // The simulator, the algorithms, and the script engine live on simThread;
+  // the GUI talks to them only through queued signals and slots, so that
+  // rendering and the GUI's event loop never wait for activations.
+  QThread simThread;
   Simulator sim;
   std::shared_ptr<ScriptEngine> scriptEngine;
   ParameterListModel* parameterModel;
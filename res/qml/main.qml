@@ -390,6 +390,89 @@ ApplicationWindow {
       }
     }
 
+    RowLayout {
+      id: batchSizeRow
+      Layout.bottomMargin: 15
+
+      Rectangle {
+        Layout.preferredWidth: 130
+        Text {
+          anchors.left: parent.left
+          text: "Activations per Frame:"
+        }
+      }
+
+      Rectangle {
+        Layout.preferredWidth: 30
+        Text {
+          id: batchSizeText
+          anchors.left: parent.left
+          text: ""
+        }
+      }
+    }
+
+    Slider {
+      id: batchSizeSlider
+      objectName: "batchSizeSlider"
+      Layout.preferredWidth: parent.width
+
+      orientation: Qt.Horizontal
+      minimumValue: 0.0
+      maximumValue: 100.0
+      stepSize: 0.0
+      updateValueWhileDragging: true
+      value: 0.0
+
+      signal batchSizeChanged(int value)
+      property bool setterDisabled: false
+      property bool callbackDisabled: false
+
+      onValueChanged: {
+        if (!callbackDisabled) {
+          batchSizeChanged(transferFunc(value))
+          batchSizeText.text = sizeText(transferFunc(value))
+        }
+      }
+
+      // Breaks the call cycle between "onValueChanged" and "setBatchSize" the
+      // same way as the step duration slider does.
+      onPressedChanged: {
+        setterDisabled = !setterDisabled
+      }
+
+      function setBatchSize(size) {
+        if (!setterDisabled) {
+          callbackDisabled = true
+          value = invTransferFunc(size)
+          callbackDisabled = false
+          batchSizeText.text = sizeText(size)
+        }
+      }
+
+      function sizeText(size) {
+        return (size === 0) ? "auto" : size
+      }
+
+      // The slider covers batch sizes from 1 to about 10^5 logarithmically;
+      // its rightmost position selects adaptive batches (size 0).
+      function transferFunc(val) {
+        if (val >= 100) {
+          return 0
+        }
+
+        return Math.round(Math.pow(10, val / 20))
+      }
+
+      function invTransferFunc(size) {
+        if (size === 0) {
+          return 100
+        }
+
+        return Math.min(99, 20 * Math.log(size) / Math.LN10)
+      }
+    }
+
     RowLayout {
       id: controlButtonRow
       spacing: 5
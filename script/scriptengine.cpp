@@ -11,8 +11,10 @@
 #include "script/scriptinterface.h"
 
 ScriptEngine::ScriptEngine(Simulator& sim, VisItem* vis, AlgorithmList* algList)
-  : scriptInterface(new ScriptInterface(*this, sim, vis)),
-    _algList(algList) {
+  : sim(sim),
+    scriptInterface(new ScriptInterface(*this, sim, vis)),
+    _algList(algList),
+    running(false) {
   // Create a global object for the JavaScript engine and make its methods
   // globally accessible. The engine owns the script interface.
   auto globalObject = engine.newQObject(scriptInterface);
@@ -42,5 +44,21 @@ void ScriptEngine::runScript(const QString scriptFilePath) {
 
   scriptFile.close();
 
-  engine.evaluate(script);
+  const bool nested = running;
+  if (!nested) {
+    sim.clearCancel();
+    running = true;
+  }
+  const QJSValue result = engine.evaluate(script);
+  running = nested;
+
+  // A stopped nested script also stops the script that ran it, which is then
+  // logged once at the top level.
+  if (result.isError() && !(nested && sim.isCancelled())) {
+    emit log(result.toString(), true);
+  }
+}
+
+void ScriptEngine::abort(const QString msg) {
+  engine.throwError(msg);
 }
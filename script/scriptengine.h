@@ -26,12 +26,22 @@ class ScriptEngine : public QObject {
   void log(const QString msg, bool error = false);
 
  public slots:
+  // Runs the script at the given path, logging the error that ended it if any.
+  // A script started while no other is running first clears any cancel pending
+  // from an earlier script (see Simulator::clearCancel).
   void runScript(const QString scriptFilePath);
 
+ public:
+  // Ends the running script with an error carrying the given message once the
+  // current script command returns. Only to be called from script commands.
+  void abort(const QString msg);
+
  private:
+  Simulator& sim;
   QJSEngine engine;
   ScriptInterface* scriptInterface;
   AlgorithmList* _algList;
+  bool running;
 };
 
 #endif  // AMOEBOTSIM_SCRIPT_SCRIPTENGINE_H_
@@ -10,6 +10,7 @@
 
 #include "alg/shapeformation.h"
 #include "core/node.h"
+#include "core/scheduler.h"
 
 ScriptInterface::ScriptInterface(ScriptEngine &engine, Simulator& sim,
                                  VisItem *vis)
@@ -24,7 +25,10 @@ void ScriptInterface::log(const QString msg, bool error) {
 }
 
 void ScriptInterface::runScript(const QString scriptFilePath) {
-  engine.runScript(scriptFilePath);
+  if (!stopped()) {
+    engine.runScript(scriptFilePath);
+    stopped();
+  }
 }
 
 void ScriptInterface::writeToFile(const QString filePath, const QString text) {
@@ -42,7 +46,9 @@ void ScriptInterface::writeToFile(const QString filePath, const QString text) {
 }
 
 void ScriptInterface::step() {
-  sim.step();
+  if (!stopped()) {
+    sim.step();
+  }
 }
 
 void ScriptInterface::setStepDuration(const int ms) {
@@ -54,8 +60,59 @@ void ScriptInterface::setStepDuration(const int ms) {
   }
 }
 
+void ScriptInterface::setBatchSize(const int size) {
+  if (size < 0) {
+    log("Batch size must be non-negative", true);
+  } else {
+    sim.setBatchSize(size);
+  }
+}
+
+void ScriptInterface::setFrameBudget(const int ms) {
+  if (ms <= 0) {
+    log("Frame budget must be positive", true);
+  } else {
+    sim.setFrameBudget(ms);
+  }
+}
+
 void ScriptInterface::runUntilTermination() {
-  sim.runUntilTermination();
+  if (!stopped()) {
+    sim.runUntilTermination();
+    stopped();
+  }
+}
+
+void ScriptInterface::setSynchronous(const bool enabled, const int numThreads) {
+  if (numThreads < 0) {
+    log("Number of threads must be non-negative", true);
+    return;
+  } else if (enabled && !sim.getSystem()->supportsSynchronousRounds()) {
+    log("Algorithm does not support synchronous rounds", true);
+  }
+  sim.setMode(enabled ? Simulator::Mode::Synchronous
+                      : Simulator::Mode::Sequential, numThreads);
+}
+
+void ScriptInterface::setParallel(const bool enabled, const int numThreads) {
+  if (numThreads < 0) {
+    log("Number of threads must be non-negative", true);
+    return;
+  } else if (enabled && !sim.getSystem()->supportsParallelActivations()) {
+    log("Algorithm does not support parallel activations", true);
+  }
+  sim.setMode(enabled ? Simulator::Mode::Parallel
+                      : Simulator::Mode::Sequential, numThreads);
+}
+
+void ScriptInterface::setScheduler(const QString policy, const int seed) {
+  for (const Scheduler::Policy candidate : Scheduler::policies) {
+    if (policy == Scheduler::name(candidate)) {
+      sim.setScheduler(candidate, seed);
+      return;
+    }
+  }
+  log("Unknown scheduler \"" + policy + "\"", true);
 }
 
 int ScriptInterface::getNumParticles() {
@@ -86,25 +143,39 @@ QVariant ScriptInterface::getMetric(QString name, bool history) {
   return QVariant();
 }
 
+// Scripts run on the simulator's thread, so the visualization is changed on
+// the GUI thread, waiting for the change before the script continues. Once the
+// simulator is cancelled these fail fast instead, as the GUI thread may be
+// waiting for the script to end while shutting down.
 void ScriptInterface::setWindowSize(int width, int height) {
-  if(vis != nullptr) {
-    vis->setWindowSize(width, height);
+  if(vis != nullptr && !stopped()) {
+    QMetaObject::invokeMethod(vis, [this, width, height]() {
+      vis->setWindowSize(width, height);
+    }, Qt::BlockingQueuedConnection);
   }
 }
 
 void ScriptInterface::focusOn(int x, int y) {
-  if (vis != nullptr) {
-    vis->focusOn(Node(x, y));
+  if (vis != nullptr && !stopped()) {
+    QMetaObject::invokeMethod(vis, [this, x, y]() {
+      vis->focusOn(Node(x, y));
+    }, Qt::BlockingQueuedConnection);
   }
 }
 
 void ScriptInterface::setZoom(float zoom) {
-  if(vis != nullptr) {
-    vis->setZoom(zoom);
+  if(vis != nullptr && !stopped()) {
+    QMetaObject::invokeMethod(vis, [this, zoom]() {
+      vis->setZoom(zoom);
+    }, Qt::BlockingQueuedConnection);
   }
 }
 
 void ScriptInterface::saveScreenshot(QString filePath) {
+  if (stopped()) {
+    return;
+  }
+
   if(filePath == "") {
     filePath = QString("amoebotsim_") +
                QString::number(QDateTime::currentSecsSinceEpoch()) + ".png";
@@ -122,12 +193,21 @@ void ScriptInterface::filmSimulation(QString filePath, const int stepLimit) {
   }
 
   int i = 0;
-  while(!sim.getSystem()->hasTerminated() && i < stepLimit) {
-    emit vis->beforeRendering();  // Updates GUI #rounds and #movements labels.
-    saveScreenshot(filePath + pad(i,fnameLen) + QString(".png"));
-    step();
+  while(!sim.getSystem()->hasTerminated() && i < stepLimit &&
+        !sim.isCancelled()) {
+    sim.saveScreenshotSetup(filePath + pad(i,fnameLen) + QString(".png"));
+    sim.step();
     ++i;
   }
+  stopped();
+}
+
+bool ScriptInterface::stopped() {
+  if (sim.isCancelled()) {
+    engine.abort("Script stopped");
+    return true;
+  }
+  return false;
 }
 
 QString ScriptInterface::pad(const int number, const int length) {
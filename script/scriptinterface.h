@@ -32,11 +32,29 @@ class ScriptInterface : public QObject {
   // Simulator flow commands. step executes a single particle activation.
   // setStepDuration sets the simulator's delay between particle activations to
   // the given value; if this value is negative, an error is logged and the step
-  // duration is set to 0. runUntilTermination runs the current algorithm
-  // instance until its hasTerminated function returns true.
+  // duration is set to 0. setBatchSize sets the number of steps the simulator
+  // takes per timer tick while running, where 0 adapts it to the frame budget
+  // set by setFrameBudget (see simulator.h); negative values are rejected with
+  // an error. runUntilTermination runs the current algorithm
+  // instance until its hasTerminated function returns true or the run is
+  // cancelled with the GUI's Stop button, which aborts the script: step,
+  // runUntilTermination, filmSimulation, and the visualization commands end
+  // the script with an error once the simulator is cancelled. setSynchronous
+  // (resp., setParallel) makes each step a synchronous round (resp., one
+  // parallel asynchronous activation per particle) on the given number of
+  // threads (0 uses one per core) if enabled; an error is logged if the current
+  // algorithm does not support this, in which case steps remain single
+  // activations. setScheduler selects the scheduler deciding which particle is
+  // activated next by name (see scheduler.h); an error is logged if there is
+  // no scheduler of the given name, in which case the scheduler is unchanged.
   void step();
   void setStepDuration(const int ms);
+  void setBatchSize(const int size);
+  void setFrameBudget(const int ms);
   void runUntilTermination();
+  void setSynchronous(const bool enabled, const int numThreads = 0);
+  void setParallel(const bool enabled, const int numThreads = 0);
+  void setScheduler(const QString policy, const int seed = 0);
 
   // Simulator metrics commands. getNumParticles and getNumObjects return the
   // number of particles and objects in the given instance, respectively.
@@ -66,6 +84,10 @@ class ScriptInterface : public QObject {
   Simulator& sim;
   VisItem* vis;
 
+  // Returns whether the simulator has been cancelled (see Simulator::cancel),
+  // in which case the running script is aborted.
+  bool stopped();
+
   // Pads the given number with leading zeroes to achieve the specified length.
   QString pad(const int number, const int length);
 };
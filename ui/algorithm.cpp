@@ -4,6 +4,9 @@
 
 #include "ui/algorithm.h"
 
+#include <QMetaMethod>
+#include <QVariant>
+
 #include "alg/demo/ballroomdemo.h"
 #include "alg/demo/discodemo.h"
 #include "alg/demo/dynamicdemo.h"
@@ -64,6 +67,56 @@ void Algorithm::addParameter(QString parameter, QString defaultValue) {
   _parameters.push_back(std::make_pair(parameter, defaultValue));
 }
 
+bool Algorithm::instantiateFromStrings(QStringList values) {
+  if (values.size() > static_cast<int>(_parameters.size())) {
+    emit log(_signature + " takes at most " +
+             QString::number(_parameters.size()) + " parameters", true);
+    return false;
+  }
+  for (int i = values.size(); i < static_cast<int>(_parameters.size()); ++i) {
+    values.append(_parameters[i].second);
+  }
+
+  // Find the instantiate slot taking all parameters. moc also registers
+  // overloads for slots with default arguments, which take fewer parameters.
+  const QMetaObject* meta = metaObject();
+  QMetaMethod method;
+  for (int i = meta->methodOffset(); i < meta->methodCount(); ++i) {
+    if (meta->method(i).name() == "instantiate" &&
+        meta->method(i).parameterCount() == values.size()) {
+      method = meta->method(i);
+      break;
+    }
+  }
+  if (!method.isValid() || values.size() > 10) {
+    emit log(_signature + " cannot be instantiated from parameters", true);
+    return false;
+  }
+
+  // Convert each value to the type of its argument. QMetaMethod::invoke takes
+  // at most ten arguments; unused ones are left as empty QGenericArguments.
+  std::vector<QVariant> args;
+  QGenericArgument genericArgs[10];
+  for (int i = 0; i < values.size(); ++i) {
+    QVariant arg(values[i]);
+    if (!arg.convert(method.parameterType(i))) {
+      emit log("invalid value \"" + values[i] + "\" for parameter " +
+               _parameters[i].first, true);
+      return false;
+    }
+    args.push_back(arg);
+  }
+  for (unsigned int i = 0; i < args.size(); ++i) {
+    genericArgs[i] = QGenericArgument(args[i].typeName(), args[i].constData());
+  }
+
+  return method.invoke(this, Qt::DirectConnection,
+                       genericArgs[0], genericArgs[1], genericArgs[2],
+                       genericArgs[3], genericArgs[4], genericArgs[5],
+                       genericArgs[6], genericArgs[7], genericArgs[8],
+                       genericArgs[9]);
+}
+
 
 // ///////////////////////////////////////////////////////////////////////////
 // My algorithms
@@ -478,6 +531,16 @@ Algorithm* AlgorithmList::getAlg(QString algName) const {
   return algo;
 }
 
+Algorithm* AlgorithmList::getAlgBySignature(QString signature) const {
+  for (auto alg : _algorithms) {
+    if (alg->getSignature().compare(signature) == 0) {
+      return alg;
+    }
+  }
+
+  return nullptr;
+}
+
 QStringList AlgorithmList::getAlgNames() const {
   QStringList names;
   for (auto alg : _algorithms) {
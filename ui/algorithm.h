@@ -36,6 +36,14 @@ class Algorithm : public QObject {
   // Adds a parameter to the algorithm of the given name and default value.
   void addParameter(QString parameter, QString defaultValue);
 
+  // Instantiates this algorithm from string-valued parameters (e.g., given on
+  // the command line), listed in the order of getParameterNames(); omitted
+  // trailing parameters take their default values. Each value is converted to
+  // the type of the corresponding argument of the subclass' instantiate slot,
+  // which is then invoked. Returns false and logs an error if there are too
+  // many values or if a value cannot be converted.
+  bool instantiateFromStrings(QStringList values);
+
  signals:
   void log(const QString msg, bool error = false);
   void setSystem(std::shared_ptr<System> system);
@@ -276,8 +284,11 @@ class AlgorithmList {
   // Returns a list of all the algorithms in this list.
   std::vector<Algorithm*> getAlgs();
 
-  // Returns the algorithm object of the given algorithm.
+  // Returns the algorithm object of the given algorithm. getAlgBySignature
+  // looks the algorithm up by its signature (e.g., "hexagonformation") instead
+  // of its name. Both return nullptr if there is no such algorithm.
   Algorithm* getAlg(QString algName) const;
+  Algorithm* getAlgBySignature(QString signature) const;
 
   // Returns a list of all the algorithm's names in this list.
   QStringList getAlgNames() const;
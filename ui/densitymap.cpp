@@ -0,0 +1,283 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "ui/densitymap.h"
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+#include <QRgb>
+
+// height of a triangle in our equilateral triangular grid if the side length is 1
+static const double triangleHeight = sqrt(3.0 / 4.0);
+
+// Returns a / b rounded down, for a positive b.
+static int floorDiv(int a, int b) {
+  return a >= 0 ? a / b : -((-a + b - 1) / b);
+}
+
+DensityMap::DensityMap()
+  : glfn(nullptr),
+    texture(0),
+    maxSize(maxMapSize),
+    cellNodes(minCellNodes),
+    originX(0),
+    originY(0),
+    width(0),
+    height(0),
+    isAllocated(false),
+    dirtyBegin(0),
+    dirtyEnd(0) {}
+
+void DensityMap::initialize(QOpenGLFunctions_2_0* glfn) {
+  this->glfn = glfn;
+  GLint maxTextureSize = 0;
+  glfn->glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxTextureSize);
+  maxSize = std::min<GLint>(maxTextureSize, +maxMapSize);
+
+  GLint previous = 0;
+  glfn->glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+  glfn->glGenTextures(1, &texture);
+  glfn->glBindTexture(GL_TEXTURE_2D, texture);
+  glfn->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glfn->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glfn->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glfn->glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glfn->glBindTexture(GL_TEXTURE_2D, previous);
+
+  isAllocated = false;
+  if (width > maxSize || height > maxSize) {
+    layout();
+  }
+}
+
+void DensityMap::deinitialize() {
+  if (glfn == nullptr) {
+    return;
+  }
+
+  glfn->glDeleteTextures(1, &texture);
+  texture = 0;
+  isAllocated = false;
+  glfn = nullptr;
+}
+
+void DensityMap::update(const RenderSnapshot& snapshot, bool all) {
+  const int size = snapshot.particles.size();
+  if (all) {
+    contributions.resize(size);
+    for (int i = 0; i < size; ++i) {
+      contributions[i] = contributionOf(snapshot.particles[i]);
+    }
+    layout();
+    return;
+  }
+
+  for (int i = size; i < static_cast<int>(contributions.size()); ++i) {
+    if (contributions[i].isPresent) {
+      add(contributions[i], -1);
+    }
+  }
+  contributions.resize(size);
+
+  // Once a particle has left the map, the layout is recomputed from all
+  // contributions anyway, so the remaining ones are only recorded.
+  bool mustLayout = false;
+  for (const int i : snapshot.changed) {
+    if (i >= size) {
+      continue;
+    }
+    const Contribution contribution = contributionOf(snapshot.particles[i]);
+    if (contribution == contributions[i]) {
+      continue;
+    }
+    if (!mustLayout && contributions[i].isPresent) {
+      add(contributions[i], -1);
+    }
+    contributions[i] = contribution;
+    if (!mustLayout) {
+      if (covers(contribution)) {
+        add(contribution, 1);
+      } else {
+        mustLayout = true;
+      }
+    }
+  }
+
+  if (mustLayout) {
+    layout();
+  }
+}
+
+void DensityMap::draw() {
+  if (glfn == nullptr || width == 0) {
+    return;
+  }
+
+  GLint previous = 0;
+  glfn->glGetIntegerv(GL_TEXTURE_BINDING_2D, &previous);
+  glfn->glBindTexture(GL_TEXTURE_2D, texture);
+  if (!isAllocated) {
+    glfn->glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA,
+                       GL_UNSIGNED_BYTE, texels.data());
+    isAllocated = true;
+  } else if (dirtyBegin < dirtyEnd) {
+    glfn->glTexSubImage2D(GL_TEXTURE_2D, 0, 0, dirtyBegin, width,
+                          dirtyEnd - dirtyBegin, GL_RGBA, GL_UNSIGNED_BYTE,
+                          &texels[4 * width * dirtyBegin]);
+  }
+  dirtyBegin = dirtyEnd = 0;
+
+  // The map's edges lie half a node beyond its outermost nodes. Lattice
+  // coordinates (x, y) are sheared into world coordinates like nodes are.
+  const double left = originX - 0.5;
+  const double right = originX + width * cellNodes - 0.5;
+  const double bottom = originY - 0.5;
+  const double top = originY + height * cellNodes - 0.5;
+  const auto vertex = [this](double x, double y) {
+    glfn->glVertex2d(x + 0.5 * y, y * triangleHeight);
+  };
+
+  glfn->glColor4d(1.0, 1.0, 1.0, 1.0);
+  glfn->glBegin(GL_QUADS);
+  glfn->glTexCoord2d(0.0, 0.0);
+  vertex(left, bottom);
+  glfn->glTexCoord2d(1.0, 0.0);
+  vertex(right, bottom);
+  glfn->glTexCoord2d(1.0, 1.0);
+  vertex(right, top);
+  glfn->glTexCoord2d(0.0, 1.0);
+  vertex(left, top);
+  glfn->glEnd();
+
+  glfn->glBindTexture(GL_TEXTURE_2D, previous);
+}
+
+bool DensityMap::Contribution::operator==(const Contribution& other) const {
+  return isPresent == other.isPresent && head == other.head &&
+         isExpanded == other.isExpanded &&
+         (!isExpanded || tail == other.tail) && color == other.color;
+}
+
+DensityMap::Contribution DensityMap::contributionOf(
+    const ParticleSnapshot& particle) {
+  Contribution contribution;
+  contribution.isPresent = true;
+  contribution.head = particle.head;
+  contribution.isExpanded = particle.globalTailDir != -1;
+  if (contribution.isExpanded) {
+    contribution.tail = particle.head.nodeInDir(particle.globalTailDir);
+  }
+  contribution.color = particle.headMarkColor;
+  return contribution;
+}
+
+void DensityMap::add(const Contribution& contribution, int sign) {
+  const int head = cellOf(contribution.head);
+  Cell& cell = cells[head];
+  cell.numNodes += sign;
+  if (contribution.color != -1) {
+    const QRgb color = contribution.color;
+    cell.numColored += sign;
+    cell.red += sign * qRed(color);
+    cell.green += sign * qGreen(color);
+    cell.blue += sign * qBlue(color);
+  }
+  writeTexel(head);
+
+  if (contribution.isExpanded) {
+    const int tail = cellOf(contribution.tail);
+    cells[tail].numNodes += sign;
+    writeTexel(tail);
+  }
+}
+
+bool DensityMap::covers(const Contribution& contribution) const {
+  const auto isInside = [this](const Node& node) {
+    return originX <= node.x && node.x < originX + width * cellNodes &&
+           originY <= node.y && node.y < originY + height * cellNodes;
+  };
+  return isInside(contribution.head) &&
+         (!contribution.isExpanded || isInside(contribution.tail));
+}
+
+int DensityMap::cellOf(const Node& node) const {
+  const int x = (node.x - originX) / cellNodes;
+  const int y = (node.y - originY) / cellNodes;
+  return y * width + x;
+}
+
+void DensityMap::layout() {
+  int minX = INT_MAX, maxX = INT_MIN, minY = INT_MAX, maxY = INT_MIN;
+  for (const Contribution& contribution : contributions) {
+    if (contribution.isPresent) {
+      for (const Node& node : {contribution.head, contribution.isExpanded
+                                   ? contribution.tail : contribution.head}) {
+        minX = std::min(minX, node.x);
+        maxX = std::max(maxX, node.x);
+        minY = std::min(minY, node.y);
+        maxY = std::max(maxY, node.y);
+      }
+    }
+  }
+
+  cells.clear();
+  texels.clear();
+  width = height = 0;
+  isAllocated = false;
+  dirtyBegin = dirtyEnd = 0;
+  if (minX > maxX) {
+    return;
+  }
+
+  // Leave room for the particles to spread out by a quarter of their extent
+  // in every direction before the layout has to be recomputed.
+  const int padX = (maxX - minX) / 4 + minCellNodes;
+  const int padY = (maxY - minY) / 4 + minCellNodes;
+  minX -= padX;
+  maxX += padX;
+  minY -= padY;
+  maxY += padY;
+
+  cellNodes = minCellNodes;
+  while ((maxX - minX) / cellNodes + 2 > maxSize ||
+         (maxY - minY) / cellNodes + 2 > maxSize) {
+    cellNodes *= 2;
+  }
+  originX = floorDiv(minX, cellNodes) * cellNodes;
+  originY = floorDiv(minY, cellNodes) * cellNodes;
+  width = (maxX - originX) / cellNodes + 1;
+  height = (maxY - originY) / cellNodes + 1;
+  cells.assign(width * height, Cell());
+  texels.assign(4 * width * height, 0);
+
+  for (const Contribution& contribution : contributions) {
+    if (contribution.isPresent) {
+      add(contribution, 1);
+    }
+  }
+}
+
+void DensityMap::writeTexel(int cell) {
+  const Cell& c = cells[cell];
+  GLubyte* texel = &texels[4 * cell];
+  if (c.numColored > 0) {
+    texel[0] = c.red / c.numColored;
+    texel[1] = c.green / c.numColored;
+    texel[2] = c.blue / c.numColored;
+  } else {
+    texel[0] = texel[1] = texel[2] = 0;
+  }
+  texel[3] = std::min(255, 255 * c.numNodes / (cellNodes * cellNodes));
+
+  const int row = cell / width;
+  if (dirtyBegin < dirtyEnd) {
+    dirtyBegin = std::min(dirtyBegin, row);
+    dirtyEnd = std::max(dirtyEnd, row + 1);
+  } else {
+    dirtyBegin = row;
+    dirtyEnd = row + 1;
+  }
+}
@@ -0,0 +1,108 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the coarse representation ParticleRenderer draws instead of sprites
+// when the view is zoomed out so far that a particle covers less than a pixel.
+// The lattice is partitioned into cells of cellNodes x cellNodes nodes, and
+// every cell becomes one texel of a texture: its opacity is the fraction of
+// the cell's nodes occupied by particles and its color is the mean head mark
+// color of the particles whose head lies in it (or black if none has a head
+// mark). Since cells are aligned with the lattice rather than the screen, the
+// texture is drawn as a single parallelogram following the lattice's shear.
+// The map remembers every particle's contribution, so it is updated from the
+// particles that changed since the last snapshot, and only the rows of texels
+// containing changed cells are uploaded again. The map covers the bounding box
+// of the particles with some room to grow; once a particle leaves it, the
+// layout is recomputed, coarsening the cells so that the map has at most
+// maxMapSize texels a side (or the OpenGL implementation's maximum texture
+// size, if smaller). The map is only drawn when a particle covers less than a
+// pixel, so this loses little detail, and it bounds the map's memory (about 25
+// MB) however far the particles are spread out.
+
+#ifndef AMOEBOTSIM_UI_DENSITYMAP_H_
+#define AMOEBOTSIM_UI_DENSITYMAP_H_
+
+#include <vector>
+
+#include <QOpenGLFunctions_2_0>
+
+#include "core/node.h"
+#include "core/rendersnapshot.h"
+
+class DensityMap {
+ public:
+  DensityMap();
+
+  DensityMap(const DensityMap&) = delete;
+  DensityMap& operator=(const DensityMap&) = delete;
+
+  // Creates (resp., deletes) the map's texture using the given OpenGL
+  // functions, whose context must be current.
+  void initialize(QOpenGLFunctions_2_0* glfn);
+  void deinitialize();
+
+  // Brings the cells up to date with the given snapshot, considering only its
+  // changed particles unless all is true.
+  void update(const RenderSnapshot& snapshot, bool all);
+
+  // Uploads the changed texels and draws the map. Leaves the texture that was
+  // bound before bound.
+  void draw();
+
+ private:
+  struct Cell {
+    int numNodes = 0;    // Occupied by particles.
+    int numColored = 0;  // Particles with a head mark whose head is here.
+    int red = 0, green = 0, blue = 0;
+  };
+
+  // What a single particle contributes to the map.
+  struct Contribution {
+    bool isPresent = false;
+    Node head;
+    Node tail;
+    bool isExpanded = false;
+    int color = -1;
+
+    bool operator==(const Contribution& other) const;
+  };
+
+  static Contribution contributionOf(const ParticleSnapshot& particle);
+
+  // Adds (if sign is 1) or subtracts (if sign is -1) the given contribution,
+  // which must be covered by the map, and updates the affected texels.
+  void add(const Contribution& contribution, int sign);
+
+  // Returns whether all nodes of the given contribution lie in the map.
+  bool covers(const Contribution& contribution) const;
+
+  // Returns the index of the cell containing the given node.
+  int cellOf(const Node& node) const;
+
+  // Recomputes the map's extent and cell size from the particles' bounding
+  // box and adds every contribution again.
+  void layout();
+
+  // Recomputes the given cell's texel.
+  void writeTexel(int cell);
+
+  static const int minCellNodes = 4;
+  static const int maxMapSize = 1024;
+
+  QOpenGLFunctions_2_0* glfn;
+  GLuint texture;
+  GLint maxSize;  // The largest width and height of the map, in cells.
+
+  int cellNodes;         // Side length of a cell in nodes.
+  int originX, originY;  // The first node of the first cell.
+  int width, height;     // In cells.
+  std::vector<Cell> cells;
+  std::vector<GLubyte> texels;
+  std::vector<Contribution> contributions;  // Indexed like the particles.
+
+  bool isAllocated;      // Whether the texture has the map's size.
+  int dirtyBegin, dirtyEnd;  // The rows of texels to upload.
+};
+
+#endif  // AMOEBOTSIM_UI_DENSITYMAP_H_
@@ -0,0 +1,381 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "ui/particlerenderer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+// height of a triangle in our equilateral triangular grid if the side length is 1
+static const double triangleHeight = sqrt(3.0 / 4.0);
+
+ParticleRenderer::ParticleRenderer()
+  : glfn(nullptr),
+    version(0),
+    numParticles(0),
+    numWithBorders(0),
+    isCoarse(false),
+    spritesStale(true),
+    tilesChanged(true) {}
+
+void ParticleRenderer::initialize(QOpenGLFunctions_2_0* glfn) {
+  this->glfn = glfn;
+  version = 0;
+  for (SpriteBuffer* buffer : {&marks, &bodies, &borders, &borderPoints,
+                               &objects}) {
+    glfn->glGenBuffers(1, &buffer->id);
+    buffer->capacity = 0;
+    buffer->uploadAll = true;
+  }
+  for (IndexBuffer* buffer : {&visibleMarks, &visibleBodies}) {
+    glfn->glGenBuffers(1, &buffer->id);
+  }
+  tilesChanged = true;
+  densityMap.initialize(glfn);
+}
+
+void ParticleRenderer::deinitialize() {
+  if (glfn == nullptr) {
+    return;
+  }
+
+  for (SpriteBuffer* buffer : {&marks, &bodies, &borders, &borderPoints,
+                               &objects}) {
+    glfn->glDeleteBuffers(1, &buffer->id);
+    buffer->id = 0;
+    buffer->capacity = 0;
+  }
+  for (IndexBuffer* buffer : {&visibleMarks, &visibleBodies}) {
+    glfn->glDeleteBuffers(1, &buffer->id);
+    buffer->id = 0;
+  }
+  densityMap.deinitialize();
+  glfn = nullptr;
+}
+
+void ParticleRenderer::setView(const QRectF& visibleRect, double zoom) {
+  this->visibleRect = visibleRect;
+  isCoarse = zoom < coarseZoom;
+}
+
+void ParticleRenderer::update(const RenderSnapshot& snapshot) {
+  if (glfn == nullptr) {
+    return;
+  }
+
+  if (snapshot.version != version) {
+    const bool all = snapshot.allChanged || version == 0;
+    version = snapshot.version;
+    densityMap.update(snapshot, all);
+    if (isCoarse || all) {
+      spritesStale = true;
+    } else if (!spritesStale) {
+      writeParticles(snapshot, false);
+    }
+    if (all || objects.vertices.size() != 4 * snapshot.objects.size()) {
+      writeObjects(snapshot);
+    }
+  }
+  if (spritesStale && !isCoarse) {
+    writeParticles(snapshot, true);
+    spritesStale = false;
+  }
+
+  upload(marks, 8);
+  upload(bodies, 4);
+  upload(borders, 0);
+  upload(borderPoints, 0);
+  upload(objects, 0);
+}
+
+void ParticleRenderer::writeParticles(const RenderSnapshot& snapshot,
+                                      bool all) {
+  // Resize the particle buffers, forgetting the borders of removed particles.
+  const int size = snapshot.particles.size();
+  bool bordersChanged = all;
+  for (int i = size; i < numParticles; ++i) {
+    if (hasBorders[i]) {
+      --numWithBorders;
+      bordersChanged = true;
+    }
+    tilesChanged |= tiles.remove(i);
+  }
+  numParticles = size;
+  hasBorders.resize(size, false);
+  marks.vertices.resize(8 * size);
+  bodies.vertices.resize(4 * size);
+
+  if (all) {
+    numWithBorders = 0;
+    std::fill(hasBorders.begin(), hasBorders.end(), false);
+    tiles.clear();
+    tilesChanged = true;
+    for (int i = 0; i < size; ++i) {
+      writeParticle(snapshot, i);
+    }
+    marks.uploadAll = true;
+    bodies.uploadAll = true;
+  } else {
+    for (const int i : snapshot.changed) {
+      if (i < size && writeParticle(snapshot, i)) {
+        bordersChanged = true;
+      }
+    }
+  }
+
+  if (bordersChanged) {
+    writeBorders(snapshot);
+  }
+}
+
+void ParticleRenderer::draw() {
+  if (glfn == nullptr) {
+    return;
+  }
+
+  if (isCoarse) {
+    densityMap.draw();
+    glfn->glEnableClientState(GL_VERTEX_ARRAY);
+    glfn->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glfn->glEnableClientState(GL_COLOR_ARRAY);
+    drawBuffer(objects);
+    glfn->glDisableClientState(GL_COLOR_ARRAY);
+    glfn->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    glfn->glDisableClientState(GL_VERTEX_ARRAY);
+    glfn->glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return;
+  }
+
+  // Only cull if some particles are out of sight; otherwise, drawing all of
+  // them is cheaper than listing them.
+  const QRectF rect = visibleRect.adjusted(-spriteReach, -spriteReach,
+                                           spriteReach, spriteReach);
+  const QRectF area = TileIndex::coveringTiles(rect);
+  const bool isCulling = !area.contains(tiles.bounds());
+  if (isCulling && (tilesChanged || area != culledArea)) {
+    cull(rect);
+    culledArea = area;
+  }
+
+  glfn->glEnableClientState(GL_VERTEX_ARRAY);
+  glfn->glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+  glfn->glEnableClientState(GL_COLOR_ARRAY);
+
+  if (isCulling) {
+    drawBuffer(marks, &visibleMarks);
+    drawBuffer(bodies, &visibleBodies);
+  } else {
+    drawBuffer(marks);
+    drawBuffer(bodies);
+  }
+  drawBuffer(borders);
+  drawBuffer(borderPoints);
+  drawBuffer(objects);
+
+  glfn->glDisableClientState(GL_COLOR_ARRAY);
+  glfn->glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glfn->glDisableClientState(GL_VERTEX_ARRAY);
+  glfn->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+QPointF ParticleRenderer::nodeToWorldCoord(const Node& node) {
+  return QPointF(node.x + 0.5 * node.y, node.y * triangleHeight);
+}
+
+void ParticleRenderer::setSprite(Vertex* quad, int index, const QPointF& pos,
+                                 QRgb color, int alpha) {
+  // These values are a consequence of how the particle texture was created. The
+  // expression (90.0f / 96.0f) is done to handle the conversion between 90 dpi
+  // and 96 dpi that Inkscape does when exporting the particle.svg as a .png.
+  static constexpr int texSize = 8;
+  static constexpr double invTexSize = (90.0 / 96.0) / texSize;
+  static constexpr double halfQuadSideLength = 256.0 / 220.0;
+
+  const GLfloat left = pos.x() - halfQuadSideLength;
+  const GLfloat right = pos.x() + halfQuadSideLength;
+  const GLfloat bottom = pos.y() - halfQuadSideLength;
+  const GLfloat top = pos.y() + halfQuadSideLength;
+  const GLfloat texLeft = invTexSize * (index % texSize);
+  const GLfloat texRight = texLeft + invTexSize;
+  const GLfloat texBottom = invTexSize * (index / texSize);
+  const GLfloat texTop = texBottom + invTexSize;
+  const GLubyte r = qRed(color), g = qGreen(color), b = qBlue(color);
+  const GLubyte a = alpha;
+
+  quad[0] = {left, bottom, texLeft, texBottom, r, g, b, a};
+  quad[1] = {right, bottom, texRight, texBottom, r, g, b, a};
+  quad[2] = {right, top, texRight, texTop, r, g, b, a};
+  quad[3] = {left, top, texLeft, texTop, r, g, b, a};
+}
+
+void ParticleRenderer::clearSprite(Vertex* quad) {
+  std::fill(quad, quad + 4, Vertex{0, 0, 0, 0, 0, 0, 0, 0});
+}
+
+bool ParticleRenderer::writeParticle(const RenderSnapshot& snapshot, int i) {
+  const ParticleSnapshot& p = snapshot.particles[i];
+  const QPointF pos = nodeToWorldCoord(p.head);
+
+  Vertex* mark = &marks.vertices[8 * i];
+  if (p.headMarkColor != -1) {
+    setSprite(mark, p.headMarkDir + 8, pos, p.headMarkColor, 180);
+  } else {
+    clearSprite(mark);
+  }
+  if (p.globalTailDir != -1 && p.tailMarkColor > -1) {
+    const QPointF tailPos = nodeToWorldCoord(p.head.nodeInDir(p.globalTailDir));
+    setSprite(mark + 4, p.tailMarkDir + 8, tailPos, p.tailMarkColor, 180);
+  } else {
+    clearSprite(mark + 4);
+  }
+  setSprite(&bodies.vertices[4 * i], p.globalTailDir + 1, pos, 0x000000, 255);
+  markDirty(marks, i);
+  markDirty(bodies, i);
+  tilesChanged |= tiles.place(i, pos);
+
+  const auto noColor = [](int color) { return color == -1; };
+  const bool had = hasBorders[i];
+  const bool has =
+      !std::all_of(p.borderColors.begin(), p.borderColors.end(), noColor) ||
+      !std::all_of(p.borderPointColors.begin(), p.borderPointColors.end(),
+                   noColor);
+  hasBorders[i] = has;
+  numWithBorders += static_cast<int>(has) - static_cast<int>(had);
+  return had || has;
+}
+
+void ParticleRenderer::writeBorders(const RenderSnapshot& snapshot) {
+  borders.vertices.clear();
+  borderPoints.vertices.clear();
+  borders.uploadAll = true;
+  borderPoints.uploadAll = true;
+  if (numWithBorders == 0) {
+    return;
+  }
+
+  for (int i = 0; i < numParticles; ++i) {
+    if (!hasBorders[i]) {
+      continue;
+    }
+    const ParticleSnapshot& p = snapshot.particles[i];
+    const QPointF pos = nodeToWorldCoord(p.head);
+    for (unsigned int j = 0; j < p.borderColors.size(); ++j) {
+      if (p.borderColors[j] != -1) {
+        borders.vertices.resize(borders.vertices.size() + 4);
+        setSprite(&borders.vertices.end()[-4], j + 21, pos, p.borderColors[j],
+                  180);
+      }
+    }
+    for (unsigned int j = 0; j < p.borderPointColors.size(); ++j) {
+      if (p.borderPointColors[j] != -1) {
+        borderPoints.vertices.resize(borderPoints.vertices.size() + 4);
+        setSprite(&borderPoints.vertices.end()[-4], j + 15, pos,
+                  p.borderPointColors[j], 255);
+      }
+    }
+  }
+}
+
+void ParticleRenderer::writeObjects(const RenderSnapshot& snapshot) {
+  objects.vertices.resize(4 * snapshot.objects.size());
+  for (size_t i = 0; i < snapshot.objects.size(); ++i) {
+    setSprite(&objects.vertices[4 * i], 39,
+              nodeToWorldCoord(snapshot.objects[i]), 0x000000, 255);
+  }
+  objects.uploadAll = true;
+}
+
+void ParticleRenderer::markDirty(SpriteBuffer& buffer, int particle) {
+  const int block = particle / blockSize;
+  if (block >= static_cast<int>(buffer.isDirty.size())) {
+    buffer.isDirty.resize(block + 1, false);
+  }
+  if (!buffer.isDirty[block]) {
+    buffer.isDirty[block] = true;
+    buffer.dirtyBlocks.push_back(block);
+  }
+}
+
+void ParticleRenderer::upload(SpriteBuffer& buffer, int verticesPerParticle) {
+  const size_t size = buffer.vertices.size();
+  if (size > 0) {
+    glfn->glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+    if (size > buffer.capacity) {
+      buffer.capacity = buffer.vertices.capacity();
+      glfn->glBufferData(GL_ARRAY_BUFFER, buffer.capacity * sizeof(Vertex),
+                         nullptr, GL_DYNAMIC_DRAW);
+      buffer.uploadAll = true;
+    }
+
+    if (buffer.uploadAll) {
+      glfn->glBufferSubData(GL_ARRAY_BUFFER, 0, size * sizeof(Vertex),
+                            buffer.vertices.data());
+    } else {
+      const size_t blockVertices = blockSize * verticesPerParticle;
+      for (const int block : buffer.dirtyBlocks) {
+        const size_t begin = block * blockVertices;
+        const size_t end = std::min(begin + blockVertices, size);
+        if (begin < end) {
+          glfn->glBufferSubData(GL_ARRAY_BUFFER, begin * sizeof(Vertex),
+                                (end - begin) * sizeof(Vertex),
+                                &buffer.vertices[begin]);
+        }
+      }
+    }
+  }
+
+  for (const int block : buffer.dirtyBlocks) {
+    buffer.isDirty[block] = false;
+  }
+  buffer.dirtyBlocks.clear();
+  buffer.uploadAll = false;
+}
+
+void ParticleRenderer::cull(const QRectF& rect) {
+  visibleMarks.indices.clear();
+  visibleBodies.indices.clear();
+  tiles.forEachIn(rect, [this](int i) {
+    for (GLuint k = 8 * i; k < 8 * i + 8u; ++k) {
+      visibleMarks.indices.push_back(k);
+    }
+    for (GLuint k = 4 * i; k < 4 * i + 4u; ++k) {
+      visibleBodies.indices.push_back(k);
+    }
+  });
+
+  for (IndexBuffer* buffer : {&visibleMarks, &visibleBodies}) {
+    glfn->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffer->id);
+    glfn->glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                       buffer->indices.size() * sizeof(GLuint),
+                       buffer->indices.data(), GL_STREAM_DRAW);
+  }
+  glfn->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  tilesChanged = false;
+}
+
+void ParticleRenderer::drawBuffer(const SpriteBuffer& buffer,
+                                  const IndexBuffer* visible) {
+  if (buffer.vertices.empty() ||
+      (visible != nullptr && visible->indices.empty())) {
+    return;
+  }
+
+  const GLsizei stride = sizeof(Vertex);
+  glfn->glBindBuffer(GL_ARRAY_BUFFER, buffer.id);
+  glfn->glVertexPointer(2, GL_FLOAT, stride,
+                        reinterpret_cast<void*>(offsetof(Vertex, x)));
+  glfn->glTexCoordPointer(2, GL_FLOAT, stride,
+                          reinterpret_cast<void*>(offsetof(Vertex, s)));
+  glfn->glColorPointer(4, GL_UNSIGNED_BYTE, stride,
+                       reinterpret_cast<void*>(offsetof(Vertex, r)));
+  if (visible != nullptr) {
+    glfn->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, visible->id);
+    glfn->glDrawElements(GL_QUADS, visible->indices.size(), GL_UNSIGNED_INT,
+                         nullptr);
+    glfn->glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  } else {
+    glfn->glDrawArrays(GL_QUADS, 0, buffer.vertices.size());
+  }
+}
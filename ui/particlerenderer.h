@@ -0,0 +1,167 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines the retained-mode renderer VisItem draws particles and objects with.
+// Every sprite (a textured quad cut from the particle texture) is stored as
+// four vertices in OpenGL vertex buffers. Each particle has fixed slots for
+// its head mark, tail mark, and body, so a changed particle is updated in
+// place; border segments and border points, which few algorithms use, are
+// kept in separate buffers that are rebuilt only when a particle with borders
+// changes. Buffers are uploaded in blocks of particles, and only the blocks
+// containing changed particles (see RenderSnapshot::changed) are uploaded
+// again, so a frame costs a handful of draw calls plus time proportional to
+// the number of changed particles. Sprites are expanded into quads on the CPU
+// and drawn with vertex arrays, which OpenGL 2.0 (and thus software OpenGL
+// implementations) supports without instancing or shaders.
+//
+// Particles are also bucketed by position in a TileIndex. If only part of the
+// system is visible, the marks and bodies are drawn through index buffers
+// listing the sprites of the particles in the visible tiles, so zooming in on
+// a large system draws only the particles near the view. The index buffers are
+// rebuilt only when the visible tiles change or particles move between tiles.
+// Below coarseZoom, the particles are drawn as a DensityMap instead, and the
+// sprites are left stale until the view is zoomed in again.
+
+#ifndef AMOEBOTSIM_UI_PARTICLERENDERER_H_
+#define AMOEBOTSIM_UI_PARTICLERENDERER_H_
+
+#include <vector>
+
+#include <QOpenGLFunctions_2_0>
+#include <QPointF>
+#include <QRectF>
+#include <QRgb>
+
+#include "core/node.h"
+#include "core/rendersnapshot.h"
+#include "ui/densitymap.h"
+#include "ui/tileindex.h"
+
+class ParticleRenderer {
+ public:
+  ParticleRenderer();
+
+  ParticleRenderer(const ParticleRenderer&) = delete;
+  ParticleRenderer& operator=(const ParticleRenderer&) = delete;
+
+  // Creates (resp., deletes) the renderer's buffers using the given OpenGL
+  // functions, whose context must be current. After initialize, the next
+  // update uploads everything.
+  void initialize(QOpenGLFunctions_2_0* glfn);
+  void deinitialize();
+
+  // Sets the visible rectangle (in world coordinates, with top() not exceeding
+  // bottom()) and the zoom (in pixels per world unit) of the next frames.
+  void setView(const QRectF& visibleRect, double zoom);
+
+  // Brings the buffers (or the density map, if zoomed out below coarseZoom) up
+  // to date with the given snapshot, uploading only the particles that changed
+  // since the snapshot passed last time.
+  void update(const RenderSnapshot& snapshot);
+
+  // Draws the marks, then the bodies, then the borders, then the border points
+  // of the particles near the visible rectangle, followed by all objects. Below
+  // coarseZoom, draws the density map instead of the particles. The particle
+  // texture must be bound.
+  void draw();
+
+  // Returns the world coordinates of the given node.
+  static QPointF nodeToWorldCoord(const Node& node);
+
+ private:
+  struct Vertex {
+    GLfloat x, y;
+    GLfloat s, t;
+    GLubyte r, g, b, a;
+  };
+
+  // A vertex buffer and the vertices it holds (four per sprite). dirtyBlocks
+  // lists the blocks of blockSize particles whose vertices have to be uploaded
+  // again; buffers that are always uploaded as a whole use uploadAll instead.
+  struct SpriteBuffer {
+    GLuint id = 0;
+    size_t capacity = 0;  // # of vertices allocated on the GPU.
+    std::vector<Vertex> vertices;
+    std::vector<int> dirtyBlocks;
+    std::vector<bool> isDirty;
+    bool uploadAll = true;
+  };
+
+  // An element buffer listing the vertices of some of a SpriteBuffer's quads.
+  struct IndexBuffer {
+    GLuint id = 0;
+    std::vector<GLuint> indices;
+  };
+
+  // Writes the sprite of the given index in the particle texture, centered at
+  // the given position and tinted with the given color, to the four vertices
+  // starting at quad. clearSprite writes an invisible sprite instead.
+  static void setSprite(Vertex* quad, int index, const QPointF& pos,
+                        QRgb color, int alpha);
+  static void clearSprite(Vertex* quad);
+
+  // Brings the particle sprites up to date with the given snapshot, rewriting
+  // only its changed particles unless all is true.
+  void writeParticles(const RenderSnapshot& snapshot, bool all);
+
+  // Writes the mark and body sprites of the particle at the given index of the
+  // given snapshot and marks its block dirty. Returns true if the particle had
+  // or has borders or border points (so that they must be rewritten), and
+  // updates numWithBorders accordingly.
+  bool writeParticle(const RenderSnapshot& snapshot, int i);
+
+  // Rebuilds the sprites of all borders and border points, respectively all
+  // objects, from the given snapshot.
+  void writeBorders(const RenderSnapshot& snapshot);
+  void writeObjects(const RenderSnapshot& snapshot);
+
+  // Marks the block of the given particle dirty in the given buffer.
+  static void markDirty(SpriteBuffer& buffer, int particle);
+
+  // Uploads the given buffer's dirty blocks (or all of it), where a block
+  // holds the vertices of blockSize particles with the given number of
+  // vertices each, reallocating the buffer if it is too small.
+  void upload(SpriteBuffer& buffer, int verticesPerParticle);
+
+  // Rebuilds the index buffers of the marks and bodies of the particles in the
+  // tiles intersecting the given rectangle and uploads them.
+  void cull(const QRectF& rect);
+
+  // Draws all vertices of the given buffer, or only the ones listed in the
+  // given index buffer if it is not nullptr.
+  void drawBuffer(const SpriteBuffer& buffer,
+                  const IndexBuffer* visible = nullptr);
+
+  static const int blockSize = 256;
+
+  // How far (in world units) a particle's sprites may extend from its head.
+  static constexpr double spriteReach = 2.5;
+
+  // The zoom below which particles cover less than about a pixel each.
+  static constexpr double coarseZoom = 1.0;
+
+  QOpenGLFunctions_2_0* glfn;
+  unsigned long long version;  // Of the last snapshot passed to update.
+  int numParticles;
+  int numWithBorders;
+  std::vector<bool> hasBorders;
+  SpriteBuffer marks;         // Head and tail mark of every particle.
+  SpriteBuffer bodies;        // Body of every particle.
+  SpriteBuffer borders;
+  SpriteBuffer borderPoints;
+  SpriteBuffer objects;
+
+  QRectF visibleRect;
+  bool isCoarse;      // Whether the density map is drawn instead of sprites.
+  bool spritesStale;  // Whether the sprites missed changes while coarse.
+  DensityMap densityMap;
+
+  TileIndex tiles;
+  bool tilesChanged;  // Whether particles moved between tiles since cull.
+  QRectF culledArea;  // The tiles whose particles the index buffers list.
+  IndexBuffer visibleMarks;
+  IndexBuffer visibleBodies;
+};
+
+#endif  // AMOEBOTSIM_UI_PARTICLERENDERER_H_
@@ -0,0 +1,79 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+#include "ui/tileindex.h"
+
+bool TileIndex::place(int item, const QPointF& pos) {
+  const int x = tileCoord(pos.x());
+  const int y = tileCoord(pos.y());
+  const int64_t key = tileKey(x, y);
+  if (item < static_cast<int>(itemSlot.size())) {
+    if (itemSlot[item] != -1 && itemTile[item] == key) {
+      return false;
+    }
+    remove(item);
+  } else {
+    itemTile.resize(item + 1, 0);
+    itemSlot.resize(item + 1, -1);
+  }
+
+  std::vector<int>& tile = tiles[key];
+  itemTile[item] = key;
+  itemSlot[item] = tile.size();
+  tile.push_back(item);
+
+  if (minX > maxX) {
+    minX = maxX = x;
+    minY = maxY = y;
+  } else {
+    minX = std::min(minX, x);
+    maxX = std::max(maxX, x);
+    minY = std::min(minY, y);
+    maxY = std::max(maxY, y);
+  }
+  return true;
+}
+
+bool TileIndex::remove(int item) {
+  if (item >= static_cast<int>(itemSlot.size()) || itemSlot[item] == -1) {
+    return false;
+  }
+
+  // Move the tile's last item into the removed item's slot.
+  const auto tile = tiles.find(itemTile[item]);
+  std::vector<int>& items = tile->second;
+  const int last = items.back();
+  items[itemSlot[item]] = last;
+  itemSlot[last] = itemSlot[item];
+  items.pop_back();
+  itemSlot[item] = -1;
+  if (items.empty()) {
+    tiles.erase(tile);
+  }
+  return true;
+}
+
+void TileIndex::clear() {
+  tiles.clear();
+  itemTile.clear();
+  itemSlot.clear();
+  minX = minY = 0;
+  maxX = maxY = -1;
+}
+
+QRectF TileIndex::coveringTiles(const QRectF& rect) {
+  const double left = tileSize * tileCoord(rect.left());
+  const double bottom = tileSize * tileCoord(rect.top());
+  return QRectF(QPointF(left, bottom),
+                QPointF(tileSize * (tileCoord(rect.right()) + 1),
+                        tileSize * (tileCoord(rect.bottom()) + 1)));
+}
+
+QRectF TileIndex::bounds() const {
+  if (minX > maxX) {
+    return QRectF();
+  }
+  return QRectF(QPointF(tileSize * minX, tileSize * minY),
+                QPointF(tileSize * (maxX + 1), tileSize * (maxY + 1)));
+}
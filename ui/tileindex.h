@@ -0,0 +1,111 @@
+/* Copyright (C) 2021 Joshua J. Daymude, Robert Gmyr, and Kristian Hinnenthal.
+ * The full GNU GPLv3 can be found in the LICENSE file, and the full copyright
+ * notice can be found at the top of main/main.cpp. */
+
+// Defines a bucket index of items by their position in world coordinates,
+// which ParticleRenderer uses to find the particles in the visible part of the
+// world. The plane is partitioned into square tiles of tileSize world units,
+// and every tile lists the items whose position lies in it. Only nonempty
+// tiles are stored, so the index follows the system's footprint. Items are
+// identified by small non-negative integers (particle indices); placing an item
+// that stays in its tile costs one comparison, and moving it to another tile or
+// removing it takes expected constant time. Finding the items near a rectangle
+// visits only the tiles it intersects, or all nonempty tiles if there are
+// fewer of those.
+
+#ifndef AMOEBOTSIM_UI_TILEINDEX_H_
+#define AMOEBOTSIM_UI_TILEINDEX_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <QPointF>
+#include <QRectF>
+
+class TileIndex {
+ public:
+  // The side length of a tile in world units.
+  static constexpr double tileSize = 16.0;
+
+  // Places the given item at the given position, inserting it if it is not in
+  // the index yet. Returns true if the item was inserted or changed tiles.
+  bool place(int item, const QPointF& pos);
+
+  // Removes the given item from the index. Returns false if it was not in it.
+  bool remove(int item);
+
+  // Removes all items.
+  void clear();
+
+  // Returns the union of all tiles intersecting the given rectangle, whose
+  // top() must not exceed its bottom() (as for a normalized QRectF).
+  static QRectF coveringTiles(const QRectF& rect);
+
+  // Returns a tile-aligned rectangle containing all items, which may be larger
+  // than necessary: it only grows until the next clear.
+  QRectF bounds() const;
+
+  // Calls f(item) for every item in a tile intersecting the given rectangle,
+  // which includes every item whose position lies in the rectangle.
+  template<class Function>
+  void forEachIn(const QRectF& rect, Function f) const;
+
+ private:
+  static int tileCoord(double coord);
+  static int64_t tileKey(int x, int y);
+
+  std::unordered_map<int64_t, std::vector<int>> tiles;
+  std::vector<int64_t> itemTile;
+  std::vector<int> itemSlot;  // Position in its tile's list, or -1 if absent.
+  int minX = 0, maxX = -1, minY = 0, maxY = -1;  // Bounds in tiles.
+};
+
+template<class Function>
+void TileIndex::forEachIn(const QRectF& rect, Function f) const {
+  const int left = std::max(tileCoord(rect.left()), minX);
+  const int right = std::min(tileCoord(rect.right()), maxX);
+  const int bottom = std::max(tileCoord(rect.top()), minY);
+  const int top = std::min(tileCoord(rect.bottom()), maxY);
+  if (left > right || bottom > top) {
+    return;
+  }
+
+  const int64_t numTiles =
+      static_cast<int64_t>(right - left + 1) * (top - bottom + 1);
+  if (numTiles > static_cast<int64_t>(tiles.size())) {
+    for (const auto& tile : tiles) {
+      const int x = static_cast<int>(tile.first >> 32);
+      const int y = static_cast<int>(static_cast<int32_t>(tile.first));
+      if (left <= x && x <= right && bottom <= y && y <= top) {
+        for (const int item : tile.second) {
+          f(item);
+        }
+      }
+    }
+  } else {
+    for (int y = bottom; y <= top; ++y) {
+      for (int x = left; x <= right; ++x) {
+        const auto tile = tiles.find(tileKey(x, y));
+        if (tile != tiles.end()) {
+          for (const int item : tile->second) {
+            f(item);
+          }
+        }
+      }
+    }
+  }
+}
+
+inline int TileIndex::tileCoord(double coord) {
+  return static_cast<int>(std::floor(coord / tileSize));
+}
+
+inline int64_t TileIndex::tileKey(int x, int y) {
+  return static_cast<int64_t>(static_cast<uint64_t>(static_cast<uint32_t>(x))
+                              << 32 | static_cast<uint32_t>(y));
+}
+
+#endif  // AMOEBOTSIM_UI_TILEINDEX_H_
@@ -10,7 +10,7 @@
 
 // Zoom preferences.
 static constexpr double zoomInit = 16.0;
-static constexpr double zoomMin = 4.0;
+static constexpr double zoomMin = 0.05;
 static constexpr double zoomMax = 128.0;
 static constexpr double zoomAttenuation = 500.0;
 
@@ -53,6 +53,11 @@ bool View::includes(const QPointF& headWorldPos) {
          && (headWorldPos.y() <= top() + slack);
 }
 
+double View::zoom() {
+  QMutexLocker locker(&mutex);
+  return _zoom;
+}
+
 void View::setViewportSize(int viewportWidth, int viewportHeight) {
   QMutexLocker locker(&mutex);
   _viewportWidth = viewportWidth;
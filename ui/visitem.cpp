@@ -10,7 +10,6 @@
 #include <QMutexLocker>
 #include <QOpenGLFunctions_2_0>
 #include <QQuickWindow>
-#include <QRgb>
 
 // visualisation preferences
 static constexpr float targetFramesPerSecond = 60.0f;
@@ -28,6 +27,11 @@ VisItem::VisItem(QQuickItem* parent) :
   renderTimer.start(targetFrameDuration);
 }
 
+void VisItem::setRenderSnapshots(
+    std::shared_ptr<RenderSnapshotBuffer> _snapshots) {
+  snapshots = _snapshots;
+}
+
 void VisItem::systemChanged(std::shared_ptr<System> _system) {
   system = _system;
 }
@@ -87,6 +91,8 @@ void VisItem::initialize() {
   particleTex->bind();
   particleTex->generateMipMaps();
 
+  renderer.initialize(glfn);
+
   Q_ASSERT(window() != nullptr);
   connect(&renderTimer, &QTimer::timeout, window(), &QQuickWindow::update);
 }
@@ -108,18 +114,20 @@ void VisItem::paint() {
 
   drawGrid();
 
-  if (system != nullptr) {
-    QMutexLocker locker(&system->mutex);
-
-    drawParticles();
-
-    drawObjects();
+  renderer.setView(QRectF(QPointF(view.left(), view.bottom()),
+                          QPointF(view.right(), view.top())),
+                   view.zoom());
+  if (snapshots != nullptr) {
+    renderer.update(snapshots->acquire());
   }
+  particleTex->bind();
+  renderer.draw();
 }
 
 void VisItem::deinitialize() {
   renderTimer.disconnect();
 
+  renderer.deinitialize();
   particleTex = nullptr;
   gridTex = nullptr;
 }
@@ -162,122 +170,8 @@ void VisItem::drawGrid() {
   glfn->glEnd();
 }
 
-void VisItem::drawParticles() {
-  particleTex->bind();
-  glfn->glBegin(GL_QUADS);
-
-  // Draw particle marks, then particles, then borders, then border points.
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawMarks(p);
-    }
-  }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawParticle(p);
-    }
-  }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawBorders(p);
-    }
-  }
-  for (const Particle& p : *system) {
-    if (view.includes(nodeToWorldCoord(p.head))) {
-      drawBorderPoints(p);
-    }
-  }
-
-  glfn->glEnd();
-}
-
-void VisItem::drawMarks(const Particle& p) {
-  // Draw head mark.
-  if (p.headMarkColor() != -1) {
-    auto pos = nodeToWorldCoord(p.head);
-    auto color = p.headMarkColor();
-    glfn->glColor4i(qRed(color) << 23, qGreen(color) << 23, qBlue(color) << 23, 180 << 23);
-    drawFromParticleTex(p.headMarkGlobalDir() + 8, pos);
-  }
-
-  // Draw tail mark.
-  if (p.globalTailDir != -1 && p.tailMarkColor() > -1) {
-    auto pos = nodeToWorldCoord(p.tail());
-    auto color = p.tailMarkColor();
-    glfn->glColor4i(qRed(color) << 23, qGreen(color) << 23, qBlue(color) << 23, 180 << 23);
-    drawFromParticleTex(p.tailMarkGlobalDir() + 8, pos);
-  }
-}
-
-void VisItem::drawParticle(const Particle& p) {
-  auto pos = nodeToWorldCoord(p.head);
-  glfn->glColor4f(0.0f, 0.0f, 0.0f, 1.0f);
-  drawFromParticleTex(p.globalTailDir + 1, pos);
-}
-
-void VisItem::drawBorders(const Particle& p) {
-  auto pos = nodeToWorldCoord(p.head);
-  for (unsigned int i = 0; i < p.borderColors().size(); ++i) {
-    if (p.borderColors().at(i) != -1) {
-      auto color = p.borderColors().at(i);
-      glfn->glColor4i(qRed(color) << 23, qGreen(color) << 23, qBlue(color) << 23, 180 << 23);
-      drawFromParticleTex(i + 21, pos);
-    }
-  }
-}
-
-void VisItem::drawBorderPoints(const Particle& p) {
-  auto pos = nodeToWorldCoord(p.head);
-  for (unsigned int i = 0; i < p.borderPointColors().size(); ++i) {
-    if (p.borderPointColors().at(i) != -1) {
-      auto color = p.borderPointColors().at(i);
-      glfn->glColor4i(qRed(color) << 23, qGreen(color) << 23, qBlue(color) << 23, 255 << 23);
-      drawFromParticleTex(i + 15, pos);
-    }
-  }
-}
-
-void VisItem::drawFromParticleTex(int index, const QPointF& pos) {
-  // These values are a consequence of how the particle texture was created. The
-  // expression (90.0f / 96.0f) is done to handle the conversion between 90 dpi
-  // and 96 dpi that Inkscape does when exporting the particle.svg as a .png.
-  static constexpr int texSize = 8;
-  static constexpr double invTexSize = (90.0 / 96.0) / texSize;
-  static constexpr double halfQuadSideLength = 256.0 / 220.0;
-
-  const double column = index % texSize;
-  const double row = index / texSize;
-  const QPointF texOffset(invTexSize * column, invTexSize * row);
-
-  glfn->glTexCoord2d(texOffset.x(), texOffset.y());
-  glfn->glVertex2d(pos.x() - halfQuadSideLength, pos.y() - halfQuadSideLength);
-  glfn->glTexCoord2d(texOffset.x() + invTexSize, texOffset.y());
-  glfn->glVertex2d(pos.x() + halfQuadSideLength, pos.y() - halfQuadSideLength);
-  glfn->glTexCoord2d(texOffset.x() + invTexSize, texOffset.y() + invTexSize);
-  glfn->glVertex2d(pos.x() + halfQuadSideLength, pos.y() + halfQuadSideLength);
-  glfn->glTexCoord2d(texOffset.x(), texOffset.y() + invTexSize);
-  glfn->glVertex2d(pos.x() - halfQuadSideLength, pos.y() + halfQuadSideLength);
-}
-
-void VisItem::drawObjects() {
-  glfn->glBegin(GL_QUADS);
-
-  std::deque<Object*> objects = system->getObjects();
-  for(auto t : objects) {
-      drawObject(*t);
-  }
-
-  glfn->glEnd();
-}
-
-void VisItem::drawObject(const Object& t) {
-  auto pos = nodeToWorldCoord(t._node);
-  glfn->glColor4d(0.0, 0.0, 0.0, 1.0);
-  drawFromParticleTex(39, pos);
-}
-
 QPointF VisItem::nodeToWorldCoord(const Node& node) {
-  return QPointF(node.x + 0.5 * node.y, node.y * triangleHeight);
+  return ParticleRenderer::nodeToWorldCoord(node);
 }
 
 Node VisItem::worldCoordToNode(const QPointF& worldCord) {
@@ -307,11 +201,10 @@ void VisItem::mousePressEvent(QMouseEvent* e) {
       translating = false;
       auto clickedNode = worldCoordToNode(windowCoordToWorldCoord(e->localPos()));
       QString text = "";
-      for (const auto& p : *system) {
-        if (p.head == clickedNode || (p.isExpanded() && p.tail() == clickedNode)) {
-          text = p.inspectionText();
-          break;
-        }
+      QMutexLocker locker(&system->mutex);
+      const Particle* p = system->particleAt(clickedNode);
+      if (p != nullptr) {
+        text = p->inspectionText();
       }
       while (text.endsWith('\n')) {
         text.chop(1);
@@ -17,8 +17,10 @@
 #include "core/node.h"
 #include "core/object.h"
 #include "core/particle.h"
+#include "core/rendersnapshot.h"
 #include "core/system.h"
 #include "ui/glitem.h"
+#include "ui/particlerenderer.h"
 #include "ui/view.h"
 
 class VisItem : public GLItem {
@@ -27,6 +29,9 @@ class VisItem : public GLItem {
  public:
   explicit VisItem(QQuickItem* parent = nullptr);
 
+  // Sets the buffer whose latest render snapshot is drawn in every frame.
+  void setRenderSnapshots(std::shared_ptr<RenderSnapshotBuffer> _snapshots);
+
  signals:
   void stepForParticleAt(Node node);
   void inspectParticle(QString text);
@@ -49,14 +54,6 @@ class VisItem : public GLItem {
   void setupCamera();
 
   void drawGrid();
-  void drawParticles();
-  void drawMarks(const Particle& p);
-  void drawParticle(const Particle& p);
-  void drawBorders(const Particle& p);
-  void drawBorderPoints(const Particle& p);
-  void drawFromParticleTex(int index, const QPointF& pos);
-  void drawObjects();
-  void drawObject(const Object& t);
 
   static QPointF nodeToWorldCoord(const Node& node);
   static Node worldCoordToNode(const QPointF& worldCord);
@@ -69,6 +66,7 @@ class VisItem : public GLItem {
  protected:
   std::unique_ptr<QOpenGLTexture> gridTex;
   std::unique_ptr<QOpenGLTexture> particleTex;
+  ParticleRenderer renderer;
 
   QTimer renderTimer;
 
@@ -77,6 +75,7 @@ class VisItem : public GLItem {
   bool translating;
 
   std::shared_ptr<System> system;
+  std::shared_ptr<RenderSnapshotBuffer> snapshots;
 };
 
 #endif  // AMOEBOTSIM_UI_VISITEM_H_